@@ -4,7 +4,11 @@ from torch.utils.cpp_extension import BuildExtension, CppExtension
 setup(
     name='spmm_csr_extension',
     ext_modules=[
-        CppExtension('spmm_csr_extension', ['spmm_csr.cpp']),
+        CppExtension(
+            name='spmm_csr_extension',
+            sources=['spmm_csr.cpp'],
+            extra_compile_args=['-fopenmp'],  # flaga dla OpenMP
+        ),
     ],
     cmdclass={
         'build_ext': BuildExtension
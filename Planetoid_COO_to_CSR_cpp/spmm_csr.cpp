@@ -1,40 +1,247 @@
 #include <torch/extension.h>
+#include <ATen/Dispatch.h>
+#include <ATen/OpMathType.h>
 #include <vector>
 #include <omp.h> // OpenMP - do równoległości
 
-torch::Tensor spmm_csr(
+// Jądro na surowych wskaźnikach: bez item<>() i tworzenia tensorów w pętli.
+// result[row,h,:] = ∑_{i w wierszu row} data[i,h] * dense[indices[i],h,:]
+// Akumulacja w opmath_t (float dla bfloat16), zapis w scalar_t.
+template <typename scalar_t, typename index_t>
+static void spmm_csr_kernel(
+    const index_t *indices,
+    const index_t *indptr,
+    const scalar_t *data,
+    int64_t data_row_stride,
+    int64_t data_head_stride, // 0 gdy data jest 1D (ta sama waga dla wszystkich głów)
+    const scalar_t *dense,
+    scalar_t *result,
+    int64_t num_rows,
+    int64_t num_heads,
+    int64_t feature_dim)
+{
+    using opmath_t = at::opmath_type<scalar_t>;
+
+#pragma omp parallel
+    {
+        std::vector<opmath_t> acc(feature_dim);
+
+// Równoległa pętla po wierszach macierzy CSR
+#pragma omp for schedule(dynamic, 64)
+        for (int64_t row = 0; row < num_rows; row++)
+        {
+            const int64_t start = indptr[row];
+            const int64_t end = indptr[row + 1];
+
+            for (int64_t h = 0; h < num_heads; h++)
+            { // Każda głowa działa oddzielnie
+                std::fill(acc.begin(), acc.end(), opmath_t(0));
+                for (int64_t i = start; i < end; i++)
+                {
+                    const int64_t col = indices[i];
+                    const opmath_t edge_weight = data[i * data_row_stride + h * data_head_stride]; // Waga dla konkretnej głowy
+                    const scalar_t *in_row = dense + (col * num_heads + h) * feature_dim;
+#pragma omp simd
+                    for (int64_t d = 0; d < feature_dim; d++)
+                    {
+                        acc[d] += edge_weight * static_cast<opmath_t>(in_row[d]);
+                    }
+                }
+
+                scalar_t *out_row = result + (row * num_heads + h) * feature_dim;
+                for (int64_t d = 0; d < feature_dim; d++)
+                {
+                    out_row[d] = static_cast<scalar_t>(acc[d]);
+                }
+            }
+        }
+    }
+}
+
+// Jądro gradientu wag krawędzi (backward):
+// grad_data[i,h] = <grad_out[row,h,:], dense[indices[i],h,:]>
+// Dla data 1D (jedna waga dla wszystkich głów) iloczyny są sumowane po h.
+template <typename scalar_t, typename index_t>
+static void spmm_csr_grad_data_kernel(
+    const index_t *indices,
+    const index_t *indptr,
+    const scalar_t *grad_out,
+    const scalar_t *dense,
+    scalar_t *grad_data,
+    bool per_head,
+    int64_t num_rows,
+    int64_t num_heads,
+    int64_t feature_dim)
+{
+    using opmath_t = at::opmath_type<scalar_t>;
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        for (int64_t i = indptr[row]; i < indptr[row + 1]; i++)
+        {
+            const int64_t col = indices[i];
+            opmath_t total = 0;
+            for (int64_t h = 0; h < num_heads; h++)
+            {
+                const scalar_t *g_row = grad_out + (row * num_heads + h) * feature_dim;
+                const scalar_t *in_row = dense + (col * num_heads + h) * feature_dim;
+                opmath_t acc = 0;
+#pragma omp simd reduction(+ : acc)
+                for (int64_t d = 0; d < feature_dim; d++)
+                {
+                    acc += static_cast<opmath_t>(g_row[d]) * static_cast<opmath_t>(in_row[d]);
+                }
+                if (per_head)
+                {
+                    grad_data[i * num_heads + h] = static_cast<scalar_t>(acc);
+                }
+                total += acc;
+            }
+            if (!per_head)
+            {
+                grad_data[i] = static_cast<scalar_t>(total);
+            }
+        }
+    }
+}
+
+static torch::Tensor spmm_csr_forward(
     torch::Tensor indices,
     torch::Tensor indptr,
     torch::Tensor data,
     torch::Tensor dense_matrix)
 {
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+    TORCH_CHECK(dense_matrix.dim() == 3, "dense_matrix must be 3D [N,H,D]");
+    TORCH_CHECK(data.dim() == 1 || data.dim() == 2, "data must be 1D [E] or 2D [E,H]");
+    TORCH_CHECK(data.size(0) == indices.size(0), "data and indices must have the same length");
+    TORCH_CHECK(indices.scalar_type() == indptr.scalar_type(), "indices and indptr must have the same dtype");
+    TORCH_CHECK(data.scalar_type() == dense_matrix.scalar_type(), "data and dense_matrix must have the same dtype");
+
     // Rozmiary wejściowych tensorów
     int64_t num_rows = indptr.size(0) - 1;      // Liczba węzłów
     int64_t num_heads = dense_matrix.size(1);   // Liczba głów
     int64_t feature_dim = dense_matrix.size(2); // Liczba cech (num_features)
-    auto result = torch::zeros({num_rows, num_heads, feature_dim}, data.options());
+    TORCH_CHECK(data.dim() == 1 || data.size(1) == num_heads, "data second dim must match number of heads");
 
-// Równoległa pętla po wierszach macierzy CSR
-#pragma omp parallel for
-    for (int row = 0; row < num_rows; row++)
+    indices = indices.contiguous();
+    indptr = indptr.contiguous();
+    data = data.contiguous();
+    dense_matrix = dense_matrix.contiguous();
+
+    // każdy wiersz jest w całości nadpisywany przez jądro
+    auto result = torch::empty({num_rows, num_heads, feature_dim}, dense_matrix.options());
+    int64_t data_row_stride = data.dim() == 2 ? num_heads : 1;
+    int64_t data_head_stride = data.dim() == 2 ? 1 : 0;
+
+    AT_DISPATCH_INDEX_TYPES(indices.scalar_type(), "spmm_csr_index", [&]
     {
-        int start = indptr[row].item<int>();
-        int end = indptr[row + 1].item<int>();
+        AT_DISPATCH_FLOATING_TYPES_AND(at::ScalarType::BFloat16, dense_matrix.scalar_type(), "spmm_csr", [&]
+        {
+            spmm_csr_kernel<scalar_t, index_t>(
+                indices.data_ptr<index_t>(),
+                indptr.data_ptr<index_t>(),
+                data.data_ptr<scalar_t>(),
+                data_row_stride,
+                data_head_stride,
+                dense_matrix.data_ptr<scalar_t>(),
+                result.data_ptr<scalar_t>(),
+                num_rows,
+                num_heads,
+                feature_dim);
+        });
+    });
+
+    return result;
+}
+
+// Funkcja: spmm_csr (z autograd)
+// Backward:
+//   grad_data[i,h] = <grad_out[row(i),h,:], dense[col(i),h,:]>  (suma po h dla data 1D)
+//   grad_dense     = A^T · grad_out - to samo jądro na transpozycji CSR,
+//                    budowanej w backward stabilnym sortowaniem po kolumnach.
+class SpmmCsrFunction : public torch::autograd::Function<SpmmCsrFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor data,
+        torch::Tensor dense_matrix)
+    {
+        auto result = spmm_csr_forward(indices, indptr, data, dense_matrix);
+        ctx->save_for_backward({indices.contiguous(), indptr.contiguous(), data.contiguous(), dense_matrix.contiguous()});
+        return result;
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto data = saved[2];
+        auto dense_matrix = saved[3];
+        auto grad_out = grad_outputs[0].to(dense_matrix.scalar_type()).contiguous();
+
+        int64_t num_rows = indptr.size(0) - 1;
+        int64_t num_cols = dense_matrix.size(0);
+        int64_t num_heads = dense_matrix.size(1);
+        int64_t feature_dim = dense_matrix.size(2);
 
-        for (int h = 0; h < num_heads; h++)
-        { // Każda głowa działa oddzielnie
-            torch::Tensor row_result = torch::zeros({feature_dim}, data.options());
-            for (int i = start; i < end; i++)
+        torch::Tensor grad_data, grad_dense;
+
+        if (ctx->needs_input_grad(2))
+        {
+            grad_data = torch::empty_like(data);
+            AT_DISPATCH_INDEX_TYPES(indices.scalar_type(), "spmm_csr_grad_data_index", [&]
             {
-                int col = indices[i].item<int>();
-                float edge_weight = data[i][h].item<float>(); // Waga dla konkretnej głowy
-                row_result += edge_weight * dense_matrix[col][h];
-            }
-            result[row][h].copy_(row_result);
+                AT_DISPATCH_FLOATING_TYPES_AND(at::ScalarType::BFloat16, dense_matrix.scalar_type(), "spmm_csr_grad_data", [&]
+                {
+                    spmm_csr_grad_data_kernel<scalar_t, index_t>(
+                        indices.data_ptr<index_t>(),
+                        indptr.data_ptr<index_t>(),
+                        grad_out.data_ptr<scalar_t>(),
+                        dense_matrix.data_ptr<scalar_t>(),
+                        grad_data.data_ptr<scalar_t>(),
+                        data.dim() == 2,
+                        num_rows,
+                        num_heads,
+                        feature_dim);
+                });
+            });
+        }
+
+        if (ctx->needs_input_grad(3))
+        {
+            // Transpozycja CSR: wiersze to kolumny oryginału, a indeksy to
+            // wiersze krawędzi; stabilne sortowanie zachowuje ich kolejność.
+            auto degree = (indptr.slice(0, 1) - indptr.slice(0, 0, -1)).to(torch::kInt64);
+            auto row_of_edge = torch::repeat_interleave(torch::arange(num_rows, degree.options()), degree)
+                                   .to(indices.scalar_type());
+            auto perm = std::get<1>(indices.sort(/*stable=*/true, /*dim=*/0, /*descending=*/false));
+            auto t_indices = row_of_edge.index_select(0, perm);
+            auto t_data = data.index_select(0, perm);
+            auto t_indptr = torch::zeros({num_cols + 1}, indptr.options());
+            t_indptr.slice(0, 1).copy_(torch::bincount(indices.to(torch::kInt64), {}, num_cols).cumsum(0));
+            grad_dense = spmm_csr_forward(t_indices, t_indptr, t_data, grad_out);
         }
+
+        return {torch::Tensor(), torch::Tensor(), grad_data, grad_dense};
     }
+};
 
-    return result;
+torch::Tensor spmm_csr(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor dense_matrix)
+{
+    return SpmmCsrFunction::apply(indices, indptr, data, dense_matrix);
 }
 
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Pomiar i raport mikrobenchmarków.
+//
+// Każdy przypadek jest uruchamiany najpierw warmup razy bez pomiaru (pierwsze
+// wywołanie płaci za page faulty, alokacje i rozgrzanie cache), potem reps
+// razy z osobnym pomiarem każdego powtórzenia. Raportowane są mediana i p95
+// (a nie pojedynczy pomiar), a GFLOP/s i GB/s liczone są z mediany.
+
+struct BenchCase {
+    std::string kernel;  // nazwa jądra, np. spmm3d_nhd
+    std::string graph;   // nazwa grafu
+    int64_t nodes = 0;
+    int64_t edges = 0;
+    int64_t heads = 1;
+    int64_t dim = 0;
+    int threads = 1;
+    double flops = 0.0;  // liczba operacji zmiennoprzecinkowych jednego wywołania
+    double bytes = 0.0;  // szacowany ruch pamięci jednego wywołania
+};
+
+struct BenchResult {
+    BenchCase c;
+    int reps = 0;
+    double min_ms = 0.0;
+    double median_ms = 0.0;
+    double p95_ms = 0.0;
+    double mean_ms = 0.0;
+    double stddev_ms = 0.0;
+
+    double gflops() const { return median_ms > 0.0 ? c.flops / (median_ms * 1e6) : 0.0; }
+    double gbps() const { return median_ms > 0.0 ? c.bytes / (median_ms * 1e6) : 0.0; }
+};
+
+// Percentyl q (0..1) z posortowanych próbek, interpolacja liniowa.
+inline double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double pos = q * double(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - double(lo));
+}
+
+template <typename Fn>
+BenchResult runBench(const BenchCase& c, int warmup, int reps, Fn&& fn) {
+    for (int i = 0; i < warmup; ++i) {
+        fn();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(reps);
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult r;
+    r.c = c;
+    r.reps = reps;
+    if (!samples.empty()) {
+        double sum = 0.0;
+        for (double s : samples) {
+            sum += s;
+        }
+        r.mean_ms = sum / double(samples.size());
+        double var = 0.0;
+        for (double s : samples) {
+            var += (s - r.mean_ms) * (s - r.mean_ms);
+        }
+        r.stddev_ms = std::sqrt(var / double(samples.size()));
+        r.min_ms = samples.front();
+        r.median_ms = percentile(samples, 0.5);
+        r.p95_ms = percentile(samples, 0.95);
+    }
+    return r;
+}
+
+// Raport CSV: nagłówek i jeden wiersz na przypadek. build i label są
+// powtarzane w każdym wierszu, żeby raporty z kilku buildów dało się sklejać.
+inline void writeCsv(std::ostream& out, const std::string& build, const std::string& label,
+                     const std::vector<BenchResult>& results) {
+    out << "build,label,kernel,graph,nodes,edges,heads,dim,threads,reps,min_ms,median_ms,p95_ms,mean_ms,stddev_ms,gflops,gbps\n";
+    for (const auto& r : results) {
+        out << build << ',' << label << ',' << r.c.kernel << ',' << r.c.graph << ',' << r.c.nodes << ',' << r.c.edges << ',' << r.c.heads << ','
+            << r.c.dim << ',' << r.c.threads << ',' << r.reps << ',' << r.min_ms << ',' << r.median_ms << ','
+            << r.p95_ms << ',' << r.mean_ms << ',' << r.stddev_ms << ',' << r.gflops() << ',' << r.gbps() << '\n';
+    }
+}
+
+// Raport JSON: {"context": {...}, "results": [{...}, ...]}. Nazwy jąder
+// i grafów pochodzą z linii poleceń, więc cudzysłowy i \ są escapowane.
+inline std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            out += '\\';
+        }
+        out += ch;
+    }
+    return out + "\"";
+}
+
+inline void writeJson(std::ostream& out, const std::string& build, const std::string& label, int max_threads,
+                      const std::vector<BenchResult>& results) {
+    out << "{\n  \"context\": {\"build\": " << jsonString(build) << ", \"label\": " << jsonString(label)
+        << ", \"max_threads\": " << max_threads << "},\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"kernel\": " << jsonString(r.c.kernel) << ", \"graph\": " << jsonString(r.c.graph)
+            << ", \"nodes\": " << r.c.nodes << ", \"edges\": " << r.c.edges << ", \"heads\": " << r.c.heads
+            << ", \"dim\": " << r.c.dim << ", \"threads\": " << r.c.threads << ", \"reps\": " << r.reps
+            << ", \"min_ms\": " << r.min_ms << ", \"median_ms\": " << r.median_ms << ", \"p95_ms\": " << r.p95_ms
+            << ", \"mean_ms\": " << r.mean_ms << ", \"stddev_ms\": " << r.stddev_ms << ", \"gflops\": " << r.gflops()
+            << ", \"gbps\": " << r.gbps() << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,406 @@
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../csr_matrix.h"
+#include "../dense_matrix.h"
+#include "../final/heads_benchmark/spmm_kernels.h"
+#include "../openMP/graph_binary.h"
+#include "../openMP/graph_generator.h"
+#include "../openMP/spmm_omp.h"
+#include "../openMP/text_loader.h"
+#include "bench_harness.h"
+
+#ifndef BENCH_BUILD_INFO
+#define BENCH_BUILD_INFO "unknown"
+#endif
+
+// Mikrobenchmarki jąder SpMM z repozytorium na grafach syntetycznych
+// i rzeczywistych, dla zadanych H, D i liczb wątków.
+//
+// Jądra (--kernels):
+//   spmm3d_nhd - spmm_csr_3d_partitioned, układ [N,H,D], wszystkie heady
+//                wiersza w jednym przejściu (head_block = H),
+//   spmm3d_hnd - to samo jądro w układzie [H,N,D], heady "na zewnątrz"
+//                (head_block = 1, osobne przejście po grafie dla heada),
+//   csr_dense  - spmmRows (openMP/spmm_omp.h), CSR x gęsta [N,D] w double,
+//   csr_csr    - spmm (csr_matrix.h), Gustavson A x A,
+//   load_text  - loadEdgesParallel, tylko dla grafów edges:<plik>,
+//   load_bin   - MappedGraph + odczyt indices/values, tylko dla bin:<plik>.
+//
+// Grafy (--graph, można podać kilka razy):
+//   uniform:N:deg - losowy graf N x N, deg sąsiadów na wiersz (stałe ziarno),
+//   rmat:scale:edge_factor[:a:b:c], ba:n:m, er:n:avg_degree
+//                 - grafy z openMP/graph_generator.h (R-MAT o skośnych
+//                   stopniach, Barabási-Albert, Erdős-Rényi),
+//   edges:<plik>  - lista krawędzi "row col" (np. Cora), wczytana przez mmap,
+//   bin:<plik>    - binarny graf z torch_load_txt.py (MappedGraph).
+//
+// GB/s to ruch "logiczny": każdy odczyt wiersza sąsiada liczony jest osobno,
+// bez uwzględnienia trafień w cache, więc dla małych grafów może przekraczać
+// przepustowość DRAM.
+
+namespace {
+
+struct Options {
+    std::vector<std::string> graphs;
+    std::vector<std::string> kernels = {"spmm3d_nhd", "spmm3d_hnd", "csr_dense", "csr_csr", "load_text", "load_bin"};
+    std::vector<int64_t> heads = {1, 4, 16, 64, 256, 512};
+    std::vector<int64_t> dims = {16, 64};
+    std::vector<int64_t> threads;
+    int warmup = 2;
+    int reps = 10;
+    double max_mb = 1024.0;
+    std::string format = "csv";
+    std::string out;
+    std::string label;  // opis przebiegu, raportowany obok BENCH_BUILD_INFO
+};
+
+struct BenchGraph {
+    std::string name;
+    std::string source;  // "uniform", "edges" lub "bin"
+    std::string path;
+    CSRMatrix csr;
+    std::vector<int64_t> indptr;
+    std::vector<int64_t> indices;
+
+    int64_t nodes() const { return csr.rows; }
+    int64_t edges() const { return static_cast<int64_t>(csr.col_idx.size()); }
+};
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) {
+            parts.push_back(item);
+        }
+    }
+    return parts;
+}
+
+std::vector<int64_t> parseList(const std::string& s) {
+    std::vector<int64_t> values;
+    for (const auto& item : split(s, ',')) {
+        values.push_back(std::stoll(item));
+    }
+    return values;
+}
+
+bool contains(const std::vector<std::string>& list, const std::string& name) {
+    return std::find(list.begin(), list.end(), name) != list.end();
+}
+
+void printUsage() {
+    std::cerr << "Usage: spmm_bench [--graph uniform:N:deg|rmat:scale:ef[:a:b:c]|ba:n:m|er:n:deg|edges:<file>|bin:<file>]...\n"
+                 "                  [--kernels spmm3d_nhd,spmm3d_hnd,csr_dense,csr_csr,load_text,load_bin]\n"
+                 "                  [--heads 1,4,16,64,256,512] [--dims 16,64] [--threads 1,2,4]\n"
+                 "                  [--warmup 2] [--reps 10] [--max-mb 1024]\n"
+                 "                  [--format csv|json] [--out file] [--label name]\n";
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        const std::string value = argv[++i];
+        if (arg == "--graph") {
+            opt.graphs.push_back(value);
+        } else if (arg == "--kernels") {
+            opt.kernels = split(value, ',');
+        } else if (arg == "--heads") {
+            opt.heads = parseList(value);
+        } else if (arg == "--dims") {
+            opt.dims = parseList(value);
+        } else if (arg == "--threads") {
+            opt.threads = parseList(value);
+        } else if (arg == "--warmup") {
+            opt.warmup = std::stoi(value);
+        } else if (arg == "--reps") {
+            opt.reps = std::stoi(value);
+        } else if (arg == "--max-mb") {
+            opt.max_mb = std::stod(value);
+        } else if (arg == "--format") {
+            opt.format = value;
+        } else if (arg == "--out") {
+            opt.out = value;
+        } else if (arg == "--label") {
+            opt.label = value;
+        } else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+
+    if (opt.graphs.empty()) {
+        opt.graphs.push_back("uniform:20000:16");
+    }
+    if (opt.threads.empty()) {
+        opt.threads = {1};
+        if (omp_get_max_threads() > 1) {
+            opt.threads.push_back(omp_get_max_threads());
+        }
+    }
+    if (opt.format != "csv" && opt.format != "json") {
+        throw std::invalid_argument("Unknown format '" + opt.format + "' (expected csv or json).");
+    }
+    if (opt.reps < 1 || opt.warmup < 0) {
+        throw std::invalid_argument("reps must be at least 1 and warmup non-negative.");
+    }
+    return opt;
+}
+
+// Graf losowy: każdy wiersz ma deg sąsiadów wylosowanych jednostajnie.
+CSRMatrix uniformGraph(int n, int deg) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    std::vector<int> row_idx, col_idx;
+    row_idx.reserve(size_t(n) * deg);
+    col_idx.reserve(size_t(n) * deg);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < deg; ++j) {
+            row_idx.push_back(i);
+            col_idx.push_back(pick(rng));
+        }
+    }
+    return cooToCsr(n, n, row_idx, col_idx, std::vector<double>(row_idx.size(), 1.0));
+}
+
+BenchGraph loadGraph(const std::string& spec) {
+    BenchGraph g;
+    g.name = spec;
+    const auto colon = spec.find(':');
+    g.source = spec.substr(0, colon);
+    const std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (isGeneratorSpec(spec)) {
+        g.csr = toCsrMatrix(generateGraph(spec));
+    } else if (g.source == "uniform") {
+        auto parts = split(rest, ':');
+        if (parts.size() != 2) {
+            throw std::invalid_argument("Expected uniform:N:deg, got " + spec);
+        }
+        g.csr = uniformGraph(std::stoi(parts[0]), std::stoi(parts[1]));
+    } else if (g.source == "edges") {
+        g.path = rest;
+        std::vector<int> row_idx, col_idx;
+        loadEdgesParallel(g.path, row_idx, col_idx);
+        int n = 0;
+        for (size_t i = 0; i < row_idx.size(); ++i) {
+            n = std::max(n, std::max(row_idx[i], col_idx[i]) + 1);
+        }
+        g.csr = cooToCsr(n, n, row_idx, col_idx, std::vector<double>(row_idx.size(), 1.0));
+    } else if (g.source == "bin") {
+        g.path = rest;
+        MappedGraph mapped(g.path);
+        const int n = static_cast<int>(mapped.numNodes());
+        g.csr.rows = g.csr.cols = n;
+        visitGraph(mapped, [&](auto indptr, auto indices, auto values) {
+            g.csr.row_ptr.assign(indptr.begin(), indptr.end());
+            g.csr.col_idx.assign(indices.begin(), indices.end());
+            g.csr.values.assign(values.begin(), values.end());
+        });
+    } else {
+        throw std::invalid_argument("Unknown graph source in " + spec);
+    }
+
+    g.indptr.assign(g.csr.row_ptr.begin(), g.csr.row_ptr.end());
+    g.indices.assign(g.csr.col_idx.begin(), g.csr.col_idx.end());
+    return g;
+}
+
+std::vector<float> randomFloats(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> v(n);
+    for (auto& x : v) {
+        x = dist(rng);
+    }
+    return v;
+}
+
+BenchCase baseCase(const std::string& kernel, const BenchGraph& g, int64_t heads, int64_t dim, int threads) {
+    BenchCase c;
+    c.kernel = kernel;
+    c.graph = g.name;
+    c.nodes = g.nodes();
+    c.edges = g.edges();
+    c.heads = heads;
+    c.dim = dim;
+    c.threads = threads;
+    return c;
+}
+
+// spmm_csr_3d w obu kolejnościach pętli. Wejście i wynik w tym samym układzie.
+void benchSpmm3d(const Options& opt, const BenchGraph& g, int threads, std::vector<BenchResult>& results) {
+    const int64_t N = g.nodes();
+    const int64_t E = g.edges();
+    CsrPartition part = CsrPartition::build(g.indptr.data(), N, threads);
+
+    for (int64_t H : opt.heads) {
+        for (int64_t D : opt.dims) {
+            const double mb = double(4 * (2 * N * H * D + E * H)) / (1024.0 * 1024.0);
+            if (mb > opt.max_mb) {
+                std::cerr << "skip spmm3d " << g.name << " H=" << H << " D=" << D << " (" << mb << " MB > --max-mb)\n";
+                continue;
+            }
+            auto data = randomFloats(size_t(E * H), 1);
+            auto x = randomFloats(size_t(N * H * D), 2);
+            std::vector<float> result(size_t(N * H * D));
+
+            BenchCase c = baseCase("", g, H, D, threads);
+            c.flops = 2.0 * double(E) * double(H) * double(D);
+            c.bytes = 8.0 * double(N + 1 + E) + 4.0 * double(E * H) + 4.0 * double(E * H * D) + 4.0 * double(N * H * D);
+
+            if (contains(opt.kernels, "spmm3d_nhd")) {
+                NodeMajorLayout layout{H, D};
+                SpmmInput<NodeMajorLayout> in{g.indices.data(), data.data(), x.data(), layout, H, D};
+                c.kernel = "spmm3d_nhd";
+                results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+                    spmm_csr_3d_partitioned(part, g.indptr.data(), in, result.data(), layout, H);
+                }));
+            }
+            if (contains(opt.kernels, "spmm3d_hnd")) {
+                HeadMajorLayout layout{N, D};
+                SpmmInput<HeadMajorLayout> in{g.indices.data(), data.data(), x.data(), layout, H, D};
+                c.kernel = "spmm3d_hnd";
+                results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+                    spmm_csr_3d_partitioned(part, g.indptr.data(), in, result.data(), layout, int64_t(1));
+                }));
+            }
+        }
+    }
+}
+
+void benchCsrDense(const Options& opt, const BenchGraph& g, int threads, std::vector<BenchResult>& results) {
+    const int64_t N = g.nodes();
+    const int64_t E = g.edges();
+    for (int64_t D : opt.dims) {
+        DenseMatrix<double> B(static_cast<int>(N), static_cast<int>(D), 1.0);
+        BenchCase c = baseCase("csr_dense", g, 1, D, threads);
+        c.flops = 2.0 * double(E) * double(D);
+        c.bytes = 4.0 * double(N + 1 + E) + 8.0 * double(E) + 8.0 * double(E * D) + 8.0 * double(N * D);
+        results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+            DenseMatrix<double> C = spmmRows(g.csr, B);
+        }));
+    }
+}
+
+void benchCsrCsr(const Options& opt, const BenchGraph& g, int threads, std::vector<BenchResult>& results) {
+    // liczba iloczynów częściowych = ∑ po krawędziach (i,k) stopnia wiersza k
+    double products = 0.0;
+    for (int k : g.csr.col_idx) {
+        products += double(g.csr.row_ptr[k + 1] - g.csr.row_ptr[k]);
+    }
+    const double out_nnz = double(spmm(g.csr, g.csr).col_idx.size());
+
+    BenchCase c = baseCase("csr_csr", g, 1, 0, threads);
+    c.flops = 2.0 * products;
+    c.bytes = 2.0 * (4.0 * double(g.nodes() + 1) + 12.0 * double(g.edges())) + 12.0 * products + 12.0 * out_nnz;
+    results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+        CSRMatrix C = spmm(g.csr, g.csr);
+    }));
+}
+
+// Wczytanie pliku krawędzi od zera (mmap + parsowanie). Po pierwszym
+// powtórzeniu plik jest w page cache, więc mierzone jest parsowanie, nie dysk.
+void benchLoadText(const Options& opt, const BenchGraph& g, int threads, std::vector<BenchResult>& results) {
+    BenchCase c = baseCase("load_text", g, 1, 0, threads);
+    c.bytes = double(MappedFile(g.path).size());
+    results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+        std::vector<int> row_idx, col_idx;
+        loadEdgesParallel(g.path, row_idx, col_idx);
+    }));
+}
+
+// Otwarcie grafu binarnego i odczyt sekcji indices/values (suma kontrolna,
+// żeby strony mapowania były faktycznie dotknięte).
+void benchLoadBin(const Options& opt, const BenchGraph& g, int threads, std::vector<BenchResult>& results) {
+    BenchCase c = baseCase("load_bin", g, 1, 0, threads);
+    c.bytes = double(MappedFile(g.path).size());
+    volatile double sink = 0.0;
+    results.push_back(runBench(c, opt.warmup, opt.reps, [&] {
+        MappedGraph mapped(g.path);
+        double sum = 0.0;
+        visitGraph(mapped, [&](auto indptr, auto indices, auto values) {
+            const int64_t edges = static_cast<int64_t>(indices.size());
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+            for (int64_t e = 0; e < edges; ++e) {
+                sum += double(indices[e]) + double(values[e]);
+            }
+            sum += double(indptr[indptr.size() - 1]);
+        });
+        sink = sink + sum;
+    }));
+}
+
+}  // namespace
+
+// Użycie: patrz printUsage(). Postęp na stderr, raport na stdout lub do --out.
+int main(int argc, char** argv) {
+    try {
+        Options opt = parseOptions(argc, argv);
+        const int max_threads = omp_get_max_threads();
+
+        std::vector<BenchResult> results;
+        for (const auto& spec : opt.graphs) {
+            BenchGraph g = loadGraph(spec);
+            std::cerr << "graph " << g.name << ": " << g.nodes() << " nodes, " << g.edges() << " edges\n";
+
+            for (int64_t t : opt.threads) {
+                const int threads = static_cast<int>(t);
+                omp_set_num_threads(threads);
+
+                benchSpmm3d(opt, g, threads, results);
+                if (contains(opt.kernels, "csr_dense")) {
+                    benchCsrDense(opt, g, threads, results);
+                }
+                if (contains(opt.kernels, "csr_csr")) {
+                    benchCsrCsr(opt, g, threads, results);
+                }
+                if (contains(opt.kernels, "load_text") && g.source == "edges") {
+                    benchLoadText(opt, g, threads, results);
+                }
+                if (contains(opt.kernels, "load_bin") && g.source == "bin") {
+                    benchLoadBin(opt, g, threads, results);
+                }
+            }
+        }
+        omp_set_num_threads(max_threads);
+
+        std::ofstream file;
+        if (!opt.out.empty()) {
+            file.open(opt.out);
+            if (!file) {
+                throw std::runtime_error("Cannot open " + opt.out);
+            }
+        }
+        std::ostream& out = opt.out.empty() ? std::cout : file;
+        if (opt.format == "json") {
+            writeJson(out, BENCH_BUILD_INFO, opt.label, max_threads, results);
+        } else {
+            writeCsv(out, BENCH_BUILD_INFO, opt.label, results);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+    return 0;
+}
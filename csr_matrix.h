@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Struktura CSR
+struct CSRMatrix {
+    std::vector<int> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<double> values;
+    int rows;
+    int cols;
+};
+
+// Budowa CSR z listy krawędzi COO sortowaniem przez zliczanie: histogram
+// wierszy, suma prefiksowa i stabilne rozrzucenie, więc krawędzie nie muszą
+// być posortowane po wierszu (kolejność w wierszu jak w wejściu).
+inline CSRMatrix cooToCsr(int rows, int cols,
+                          const std::vector<int>& row_idx,
+                          const std::vector<int>& col_idx,
+                          const std::vector<double>& values) {
+    if (row_idx.size() != col_idx.size() || row_idx.size() != values.size()) {
+        throw std::invalid_argument("COO arrays must have the same length.");
+    }
+    if (row_idx.size() > static_cast<size_t>(INT_MAX)) {
+        throw std::overflow_error("Too many edges for int indices.");
+    }
+
+    CSRMatrix A;
+    A.rows = rows;
+    A.cols = cols;
+    A.row_ptr.assign(rows + 1, 0);
+    A.col_idx.resize(row_idx.size());
+    A.values.resize(row_idx.size());
+
+    for (size_t i = 0; i < row_idx.size(); ++i) {
+        if (row_idx[i] < 0 || row_idx[i] >= rows || col_idx[i] < 0 || col_idx[i] >= cols) {
+            throw std::out_of_range("Edge index out of range.");
+        }
+        A.row_ptr[row_idx[i] + 1]++;
+    }
+    for (int i = 0; i < rows; ++i) {
+        A.row_ptr[i + 1] += A.row_ptr[i];
+    }
+
+    std::vector<int> fill(A.row_ptr.begin(), A.row_ptr.end() - 1);
+    for (size_t i = 0; i < row_idx.size(); ++i) {
+        int pos = fill[row_idx[i]]++;
+        A.col_idx[pos] = col_idx[i];
+        A.values[pos] = values[i];
+    }
+
+    return A;
+}
+
+// Funkcja do wykonywania SpMM (CSR x CSR) metodą Gustavsona, w dwóch fazach:
+//
+// 1. faza symboliczna - dla każdego wiersza C liczymy liczbę niezerowych
+//    kolumn (tablica znaczników na wątek), potem suma prefiksowa daje
+//    dokładny row_ptr i rozmiar col_idx/values,
+// 2. faza numeryczna - każdy wątek ma gęsty akumulator (SPA) długości
+//    B.cols; kolumny wiersza zapisywane są od razu w docelowe miejsce
+//    col_idx, sortowane w miejscu, a wartości zbierane z akumulatora.
+//
+// Obie fazy są równoległe po wierszach (OpenMP), wynik ma posortowane
+// kolumny i nie ma alokacji na wiersz - bufory są tylko na wątek.
+inline CSRMatrix spmm(const CSRMatrix& A, const CSRMatrix& B) {
+    // Sprawdzenie wymiarów
+    if (A.cols != B.rows) {
+        throw std::invalid_argument("Dimensions of matrices are not compatible for multiplication.");
+    }
+
+    const int rows = A.rows;
+    const int cols = B.cols;
+    CSRMatrix C;
+    C.rows = rows;
+    C.cols = cols;
+    C.row_ptr.assign(rows + 1, 0);
+
+    // Faza symboliczna
+#pragma omp parallel
+    {
+        std::vector<int> marker(cols, -1);
+
+#pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < rows; ++i) {
+            int count = 0;
+            for (int j = A.row_ptr[i]; j < A.row_ptr[i + 1]; ++j) {
+                int a_col = A.col_idx[j];
+                for (int k = B.row_ptr[a_col]; k < B.row_ptr[a_col + 1]; ++k) {
+                    int b_col = B.col_idx[k];
+                    if (marker[b_col] != i) {
+                        marker[b_col] = i;
+                        ++count;
+                    }
+                }
+            }
+            C.row_ptr[i + 1] = count;
+        }
+    }
+
+    int64_t nnz = 0;
+    for (int i = 0; i < rows; ++i) {
+        nnz += C.row_ptr[i + 1];
+        if (nnz > INT_MAX) {
+            throw std::overflow_error("Result has too many non-zeros for int indices.");
+        }
+        C.row_ptr[i + 1] = static_cast<int>(nnz);
+    }
+
+    C.col_idx.resize(nnz);
+    C.values.resize(nnz);
+
+    // Faza numeryczna
+#pragma omp parallel
+    {
+        std::vector<double> acc(cols, 0.0);
+        std::vector<int> marker(cols, -1);
+
+#pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < rows; ++i) {
+            int pos = C.row_ptr[i];
+            for (int j = A.row_ptr[i]; j < A.row_ptr[i + 1]; ++j) {
+                int a_col = A.col_idx[j];
+                double a_val = A.values[j];
+
+                for (int k = B.row_ptr[a_col]; k < B.row_ptr[a_col + 1]; ++k) {
+                    int b_col = B.col_idx[k];
+                    double b_val = B.values[k];
+
+                    if (marker[b_col] != i) {
+                        marker[b_col] = i;
+                        acc[b_col] = a_val * b_val;
+                        C.col_idx[pos++] = b_col;
+                    } else {
+                        acc[b_col] += a_val * b_val;
+                    }
+                }
+            }
+
+            std::sort(C.col_idx.begin() + C.row_ptr[i], C.col_idx.begin() + C.row_ptr[i + 1]);
+            for (int p = C.row_ptr[i]; p < C.row_ptr[i + 1]; ++p) {
+                C.values[p] = acc[C.col_idx[p]];
+            }
+        }
+    }
+
+    return C;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Gęsta macierz w jednym ciągłym, wyrównanym buforze.
+//
+// Zamiast std::vector<std::vector<T>> (alokacja na wiersz, skakanie po
+// wskaźnikach przy każdym B[a_col][k], brak wyrównania) wszystkie wiersze
+// leżą w jednym bloku pamięci wyrównanym do 64 bajtów. Wiersze są co stride()
+// elementów - długość wiersza zaokrąglona w górę tak, żeby każdy wiersz też
+// zaczynał się na granicy 64 bajtów. Dopełnienie jest wyzerowane.
+
+// Widok jednego wiersza: C[i][k], range-for, size().
+template <typename T>
+class RowSpan {
+public:
+    RowSpan(T* data, size_t size) : data_(data), size_(size) {}
+
+    T& operator[](size_t k) const { return data_[k]; }
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+template <typename T>
+class DenseMatrix {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    DenseMatrix() = default;
+
+    DenseMatrix(int rows, int cols, T value = T())
+        : rows_(rows), cols_(cols), stride_(padded_stride(cols)), buffer_(allocate(size_t(rows) * padded_stride(cols))) {
+        for (int i = 0; i < rows_; ++i) {
+            std::fill(row(i), row(i) + cols_, value);
+            std::fill(row(i) + cols_, row(i) + stride_, T());
+        }
+    }
+
+    DenseMatrix(std::initializer_list<std::initializer_list<T>> init)
+        : DenseMatrix(static_cast<int>(init.size()), init.size() ? static_cast<int>(init.begin()->size()) : 0) {
+        int i = 0;
+        for (const auto& r : init) {
+            if (static_cast<int>(r.size()) != cols_) {
+                throw std::invalid_argument("All rows of DenseMatrix must have the same length.");
+            }
+            std::copy(r.begin(), r.end(), row(i++));
+        }
+    }
+
+    DenseMatrix(const DenseMatrix& other) : DenseMatrix(other.rows_, other.cols_) {
+        std::copy(other.data(), other.data() + size_t(rows_) * stride_, data());
+    }
+
+    DenseMatrix& operator=(const DenseMatrix& other) {
+        if (this != &other) {
+            DenseMatrix copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    DenseMatrix(DenseMatrix&&) noexcept = default;
+    DenseMatrix& operator=(DenseMatrix&&) noexcept = default;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+    T* data() { return buffer_.get(); }
+    const T* data() const { return buffer_.get(); }
+
+    T* row(int i) { return data() + size_t(i) * stride_; }
+    const T* row(int i) const { return data() + size_t(i) * stride_; }
+
+    RowSpan<T> operator[](int i) { return RowSpan<T>(row(i), cols_); }
+    RowSpan<const T> operator[](int i) const { return RowSpan<const T>(row(i), cols_); }
+
+    T& operator()(int i, int j) { return row(i)[j]; }
+    const T& operator()(int i, int j) const { return row(i)[j]; }
+
+    // Iteracja po wierszach: for (auto r : M) { for (T v : r) ... }
+    class RowIterator {
+    public:
+        RowIterator(const DenseMatrix* m, int i) : m_(m), i_(i) {}
+        RowSpan<const T> operator*() const { return (*m_)[i_]; }
+        RowIterator& operator++() { ++i_; return *this; }
+        bool operator!=(const RowIterator& other) const { return i_ != other.i_; }
+
+    private:
+        const DenseMatrix* m_;
+        int i_;
+    };
+
+    RowIterator begin() const { return RowIterator(this, 0); }
+    RowIterator end() const { return RowIterator(this, rows_); }
+
+private:
+    struct AlignedDeleter {
+        void operator()(T* p) const {
+#ifdef _WIN32
+            _aligned_free(p);
+#else
+            std::free(p);
+#endif
+        }
+    };
+
+    static size_t padded_stride(int cols) {
+        const size_t per_line = kAlignment % sizeof(T) == 0 ? kAlignment / sizeof(T) : 1;
+        return (size_t(cols) + per_line - 1) / per_line * per_line;
+    }
+
+    static std::unique_ptr<T[], AlignedDeleter> allocate(size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        void* p = nullptr;
+#ifdef _WIN32
+        p = _aligned_malloc(count * sizeof(T), kAlignment);
+#else
+        if (posix_memalign(&p, kAlignment, count * sizeof(T)) != 0) {
+            p = nullptr;
+        }
+#endif
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return std::unique_ptr<T[], AlignedDeleter>(static_cast<T*>(p));
+    }
+
+    int rows_ = 0;
+    int cols_ = 0;
+    size_t stride_ = 0;
+    std::unique_ptr<T[], AlignedDeleter> buffer_;
+};
@@ -0,0 +1,354 @@
+#include "spmm_extension.h"
+#include "anisotropic.h"
+
+// Agregacja anizotropowa (anisotropic.h) z autograd:
+//
+// spmm_csr_3d_channel: out[row,h,d] = ∑_e weights[e,h,d] * x[col,h,d]
+// spmm_csr_3d_lowrank: out[row,h,d] = ∑_e (∑_r coef[e,h,r] * basis[h,r,d]) * x[col,h,d]
+//                      z coef [E,H,R] albo coef = edge_attr @ proj liczonym
+//                      w jądrze (proj [F,H,R], edge_attr [E,F])
+//
+// grad_x w obu przypadkach to ta sama agregacja po transpozycji (CSC) z wagami
+// krawędzi przestawionymi do kolejności CSC, jak w spmm_csr_3d. Wejścia fp32.
+
+// Transpozycja i jej podział: z CSRGraph zapisanego w forward albo liczone od nowa.
+static CsrPartition saved_transpose(
+    torch::autograd::AutogradContext *ctx,
+    const torch::autograd::variable_list &saved,
+    size_t first,
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    int64_t num_cols,
+    torch::Tensor &t_indptr,
+    torch::Tensor &t_rows,
+    torch::Tensor &t_perm)
+{
+    if (saved[first].defined())
+    {
+        t_indptr = saved[first];
+        t_rows = saved[first + 1];
+        t_perm = saved[first + 2];
+        CsrPartition part_t;
+        part_t.num_rows = t_indptr.size(0) - 1;
+        part_t.nnz = indices.size(0);
+        part_t.row_start = ctx->saved_data["row_start_t"].toIntVector();
+        part_t.edge_start = ctx->saved_data["edge_start_t"].toIntVector();
+        return part_t;
+    }
+
+    auto t = csr_transpose(indices, indptr, num_cols);
+    t_indptr = t[0];
+    t_rows = t[1];
+    t_perm = t[2];
+    return make_partition(t_indptr, 0);
+}
+
+static CsrPartition saved_partition(torch::autograd::AutogradContext *ctx, torch::Tensor indices, torch::Tensor indptr)
+{
+    CsrPartition part;
+    part.num_rows = indptr.size(0) - 1;
+    part.nnz = indices.size(0);
+    part.row_start = ctx->saved_data["row_start"].toIntVector();
+    part.edge_start = ctx->saved_data["edge_start"].toIntVector();
+    return part;
+}
+
+static void save_graph_transpose(torch::autograd::AutogradContext *ctx, const std::shared_ptr<CSRGraph> &graph,
+                                 torch::Tensor &t_indptr, torch::Tensor &t_rows, torch::Tensor &t_perm)
+{
+    if (graph)
+    {
+        t_indptr = graph->t_indptr;
+        t_rows = graph->t_rows;
+        t_perm = graph->t_perm;
+        ctx->saved_data["row_start_t"] = graph->partition_t.row_start;
+        ctx->saved_data["edge_start_t"] = graph->partition_t.edge_start;
+    }
+}
+
+static torch::Tensor channel_forward(torch::Tensor indices, torch::Tensor indptr, torch::Tensor weights, torch::Tensor x,
+                                     const CsrPartition &part)
+{
+    int64_t num_rows = indptr.size(0) - 1;
+    int64_t E = indices.size(0);
+    int64_t H = x.size(1);
+    int64_t D = x.size(2);
+
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_channel_forward", indices, indptr, weights, x);
+    op.work(E, 8 * (num_rows + 1 + E) + 4 * (2 * E * H * D + num_rows * H * D));
+
+    auto result = torch::empty({num_rows, H, D}, x.options());
+    op.alloc(result.nbytes());
+    ChannelInput in{indices.data_ptr<int64_t>(), weights.data_ptr<float>(), x.data_ptr<float>(), H, D};
+    spmm_channel_partitioned(part, indptr.data_ptr<int64_t>(), in, result.data_ptr<float>());
+    return result;
+}
+
+class SpmmCsr3dChannelFunction : public torch::autograd::Function<SpmmCsr3dChannelFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor weights,
+        torch::Tensor x,
+        std::shared_ptr<CsrPartition> partition,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+        TORCH_CHECK(weights.dim() == 3 && weights.size(0) == indices.size(0) && weights.size(1) == x.size(1) &&
+                        weights.size(2) == x.size(2),
+                    "weights must be [E,H,D] with H and D matching x");
+        TORCH_CHECK(x.scalar_type() == torch::kFloat32 && weights.scalar_type() == torch::kFloat32,
+                    "weights and x must be float32");
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        weights = weights.contiguous();
+        x = x.contiguous();
+
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+        TORCH_CHECK(part.num_rows == indptr.size(0) - 1 && part.nnz == indices.size(0),
+                    "partition was built for a different graph");
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        save_graph_transpose(ctx, graph, t_indptr, t_rows, t_perm);
+        ctx->save_for_backward({indices, indptr, weights, x, t_indptr, t_rows, t_perm});
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+        return channel_forward(indices, indptr, weights, x, part);
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto weights = saved[2];
+        auto x = saved[3];
+        auto grad_out = grad_outputs[0].to(torch::kFloat32).contiguous();
+
+        torch::Tensor grad_weights, grad_x;
+
+        if (ctx->needs_input_grad(2))
+        {
+            SPMM_OP_SCOPE(op, "spmm_csr_3d_channel_backward_weights", indices, indptr, grad_out, x);
+            op.work(indices.size(0), 8 * (indptr.size(0) + indices.size(0)) + 12 * weights.numel());
+            grad_weights = torch::empty_like(weights);
+            op.alloc(grad_weights.nbytes());
+            ChannelInput in{indices.data_ptr<int64_t>(), nullptr, x.data_ptr<float>(), x.size(1), x.size(2)};
+            channel_backward_weights(saved_partition(ctx, indices, indptr), indptr.data_ptr<int64_t>(), in,
+                                     grad_out.data_ptr<float>(), grad_weights.data_ptr<float>());
+        }
+
+        if (ctx->needs_input_grad(3))
+        {
+            torch::Tensor t_indptr, t_rows, t_perm;
+            CsrPartition part_t = saved_transpose(ctx, saved, 4, indices, indptr, x.size(0), t_indptr, t_rows, t_perm);
+            auto weights_t = weights.index_select(0, t_perm).contiguous();
+            grad_x = channel_forward(t_rows, t_indptr, weights_t, grad_out, part_t);
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_weights, grad_x, torch::Tensor(), torch::Tensor()};
+    }
+};
+
+// coef - [E,H,R] albo edge_attr [E,F] (gdy proj jest zdefiniowany)
+static torch::Tensor lowrank_forward(torch::Tensor indices, torch::Tensor indptr, torch::Tensor coef, torch::Tensor basis,
+                                     torch::Tensor x, torch::Tensor proj, const CsrPartition &part)
+{
+    int64_t num_rows = indptr.size(0) - 1;
+    int64_t E = indices.size(0);
+    int64_t H = x.size(1);
+    int64_t D = x.size(2);
+    int64_t R = basis.size(1);
+
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_lowrank_forward", indices, indptr, coef, basis, x);
+    op.work(E, 8 * (num_rows + 1 + E) + 4 * (coef.numel() + E * H * D + num_rows * H * D));
+
+    auto result = torch::empty({num_rows, H, D}, x.options());
+    op.alloc(result.nbytes());
+    LowRankInput in{indices.data_ptr<int64_t>(), coef.data_ptr<float>(),
+                    proj.defined() ? proj.data_ptr<float>() : nullptr, basis.data_ptr<float>(), x.data_ptr<float>(),
+                    H, R, D, proj.defined() ? proj.size(0) : 0};
+    spmm_lowrank_partitioned(part, indptr.data_ptr<int64_t>(), in, result.data_ptr<float>());
+    return result;
+}
+
+class SpmmCsr3dLowRankFunction : public torch::autograd::Function<SpmmCsr3dLowRankFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor coef,
+        torch::Tensor basis,
+        torch::Tensor x,
+        torch::Tensor proj,
+        std::shared_ptr<CsrPartition> partition,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+        int64_t E = indices.size(0);
+        int64_t H = x.size(1);
+        int64_t D = x.size(2);
+        TORCH_CHECK(basis.dim() == 3 && basis.size(0) == H && basis.size(2) == D,
+                    "basis must be [H,R,D] with H and D matching x");
+        int64_t R = basis.size(1);
+        if (proj.defined())
+        {
+            TORCH_CHECK(coef.dim() == 2 && coef.size(0) == E, "edge_attr must be [E,F]");
+            TORCH_CHECK(proj.dim() == 3 && proj.size(0) == coef.size(1) && proj.size(1) == H && proj.size(2) == R,
+                        "proj must be [F,H,R] matching edge_attr and basis");
+            TORCH_CHECK(proj.scalar_type() == torch::kFloat32, "proj must be float32");
+            proj = proj.contiguous();
+        }
+        else
+        {
+            TORCH_CHECK(coef.dim() == 3 && coef.size(0) == E && coef.size(1) == H && coef.size(2) == R,
+                        "coef must be [E,H,R] matching basis");
+        }
+        TORCH_CHECK(x.scalar_type() == torch::kFloat32 && coef.scalar_type() == torch::kFloat32 &&
+                        basis.scalar_type() == torch::kFloat32,
+                    "coef, basis and x must be float32");
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        coef = coef.contiguous();
+        basis = basis.contiguous();
+        x = x.contiguous();
+
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+        TORCH_CHECK(part.num_rows == indptr.size(0) - 1 && part.nnz == E, "partition was built for a different graph");
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        save_graph_transpose(ctx, graph, t_indptr, t_rows, t_perm);
+        ctx->save_for_backward({indices, indptr, coef, basis, x, proj, t_indptr, t_rows, t_perm});
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+        return lowrank_forward(indices, indptr, coef, basis, x, proj, part);
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto coef = saved[2];
+        auto basis = saved[3];
+        auto x = saved[4];
+        auto proj = saved[5];
+        auto grad_out = grad_outputs[0].to(torch::kFloat32).contiguous();
+
+        int64_t E = indices.size(0);
+        int64_t H = x.size(1);
+        int64_t D = x.size(2);
+        int64_t R = basis.size(1);
+
+        torch::Tensor grad_coef, grad_basis, grad_x, grad_proj;
+        bool need_coef = ctx->needs_input_grad(2) || (proj.defined() && ctx->needs_input_grad(5));
+
+        if (need_coef || ctx->needs_input_grad(3))
+        {
+            SPMM_OP_SCOPE(op, "spmm_csr_3d_lowrank_backward_edges", indices, indptr, grad_out, x);
+            op.work(E, 8 * (indptr.size(0) + E) + 4 * (2 * E * H * D + E * H * R));
+            if (need_coef)
+            {
+                grad_coef = torch::empty({E, H, R}, x.options());
+                op.alloc(grad_coef.nbytes());
+            }
+            if (ctx->needs_input_grad(3))
+            {
+                grad_basis = torch::empty_like(basis);
+                op.alloc(grad_basis.nbytes());
+            }
+            LowRankInput in{indices.data_ptr<int64_t>(), coef.data_ptr<float>(),
+                            proj.defined() ? proj.data_ptr<float>() : nullptr, basis.data_ptr<float>(),
+                            x.data_ptr<float>(), H, R, D, proj.defined() ? proj.size(0) : 0};
+            lowrank_backward_edges(saved_partition(ctx, indices, indptr), indptr.data_ptr<int64_t>(), in,
+                                   grad_out.data_ptr<float>(),
+                                   grad_coef.defined() ? grad_coef.data_ptr<float>() : nullptr,
+                                   grad_basis.defined() ? grad_basis.data_ptr<float>() : nullptr);
+        }
+
+        if (proj.defined() && grad_coef.defined())
+        {
+            // coef = edge_attr @ proj: gradienty przez mnożenie macierzy [E,F] x [F,H*R]
+            auto grad_coef_2d = grad_coef.view({E, H * R});
+            if (ctx->needs_input_grad(5))
+            {
+                grad_proj = coef.t().matmul(grad_coef_2d).view({proj.size(0), H, R});
+            }
+            grad_coef = ctx->needs_input_grad(2) ? grad_coef_2d.matmul(proj.view({proj.size(0), H * R}).t())
+                                                 : torch::Tensor();
+        }
+
+        if (ctx->needs_input_grad(4))
+        {
+            torch::Tensor t_indptr, t_rows, t_perm;
+            CsrPartition part_t = saved_transpose(ctx, saved, 6, indices, indptr, x.size(0), t_indptr, t_rows, t_perm);
+            auto coef_t = coef.index_select(0, t_perm).contiguous();
+            grad_x = lowrank_forward(t_rows, t_indptr, coef_t, basis, grad_out, proj, part_t);
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_coef, grad_basis, grad_x, grad_proj, torch::Tensor(), torch::Tensor()};
+    }
+};
+
+torch::Tensor spmm_csr_3d_channel(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor weights,
+    torch::Tensor x,
+    std::shared_ptr<CsrPartition> partition)
+{
+    return SpmmCsr3dChannelFunction::apply(indices, indptr, weights, x, partition, std::shared_ptr<CSRGraph>());
+}
+
+torch::Tensor spmm_csr_3d_channel_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor weights,
+    torch::Tensor x)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(x.dim() == 3 && x.size(0) == graph->num_cols, "x must be 3D [num_cols,H,D]");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SpmmCsr3dChannelFunction::apply(graph->indices, graph->indptr, weights, x, partition, graph);
+}
+
+torch::Tensor spmm_csr_3d_lowrank(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor coef,
+    torch::Tensor basis,
+    torch::Tensor x,
+    c10::optional<torch::Tensor> proj,
+    std::shared_ptr<CsrPartition> partition)
+{
+    return SpmmCsr3dLowRankFunction::apply(indices, indptr, coef, basis, x, proj.value_or(torch::Tensor()), partition,
+                                           std::shared_ptr<CSRGraph>());
+}
+
+torch::Tensor spmm_csr_3d_lowrank_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor coef,
+    torch::Tensor basis,
+    torch::Tensor x,
+    c10::optional<torch::Tensor> proj)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(x.dim() == 3 && x.size(0) == graph->num_cols, "x must be 3D [num_cols,H,D]");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SpmmCsr3dLowRankFunction::apply(graph->indices, graph->indptr, coef, basis, x, proj.value_or(torch::Tensor()),
+                                           partition, graph);
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "spmm_kernels.h"
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Agregacja anizotropowa: każda krawędź ma wagę na head i kanał, a nie
+// jedną liczbę data[e,h] na head:
+//
+//   out[row,h,d] = ∑_{e w wierszu row} w[e,h,d] * x[col(e),h,d]
+//
+// Wagi w[e,h,d] pochodzą z jednego z dwóch źródeł:
+//   - wprost: weights [E,H,D] (ChannelInput),
+//   - niskiego rzędu: w[e,h,d] = ∑_r coef[e,h,r] * basis[h,r,d] (LowRankInput),
+//     gdzie coef [E,H,R] jest podany albo liczony z cech krawędzi:
+//     coef[e,h,r] = ∑_f edge_attr[e,f] * proj[f,h,r].
+// W wariancie niskiego rzędu wagi są składane w trakcie przejścia po CSR
+// (R*D mnożeń na krawędź i head, basis[h] siedzi w L1), więc ani wagi [E,H,D],
+// ani wiadomości [E,H,D] nie trafiają do pamięci, a z edge_attr nie powstaje
+// nawet coef [E,H,R].
+
+struct ChannelInput
+{
+    const int64_t *indices;
+    const float *weights; // [E,H,D]
+    const float *x;       // [N,H,D]
+    int64_t H;
+    int64_t D;
+};
+
+struct LowRankInput
+{
+    const int64_t *indices;
+    const float *coef;  // [E,H,R], albo edge_attr [E,F] gdy proj != nullptr
+    const float *proj;  // [F,H,R] albo nullptr
+    const float *basis; // [H,R,D]
+    const float *x;     // [N,H,D]
+    int64_t H;
+    int64_t R;
+    int64_t D;
+    int64_t F;
+};
+
+// Funkcja: lowrank_edge_coef
+// Współczynniki coef[e,:,:] krawędzi i ([H*R]): wskaźnik do wejścia albo,
+// przy edge_attr, wynik edge_attr[i,:] @ proj zapisany w buf.
+inline const float *lowrank_edge_coef(const LowRankInput &in, int64_t i, float *buf)
+{
+    const int64_t HR = in.H * in.R;
+    if (!in.proj)
+    {
+        return in.coef + i * HR;
+    }
+
+    const float *attr = in.coef + i * in.F;
+    std::fill(buf, buf + HR, 0.0f);
+    for (int64_t f = 0; f < in.F; f++)
+    {
+        const float a = attr[f];
+        const float *p = in.proj + f * HR;
+#pragma omp simd
+        for (int64_t k = 0; k < HR; k++)
+        {
+            buf[k] += a * p[k];
+        }
+    }
+    return buf;
+}
+
+// Funkcja: spmm_channel_partitioned
+// result[row,h,d] = ∑_e weights[e,h,d] * x[col(e),h,d]  (układ [N,H,D])
+inline void spmm_channel_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const ChannelInput &in,
+    float *result)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+    NodeMajorLayout layout{H, D};
+
+    spmm_partitioned_rows(part, indptr, H, D, result, layout, H,
+                          [&](int64_t begin, int64_t end, int64_t h_begin, int64_t h_end, float *out, int64_t out_head_stride)
+    {
+        for (int64_t h = h_begin; h < h_end; h++)
+        {
+            float *out_head = out + (h - h_begin) * out_head_stride;
+            std::fill(out_head, out_head + D, 0.0f);
+        }
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            const float *x_row = in.x + in.indices[i] * H * D;
+            const float *w_row = in.weights + i * H * D;
+
+            for (int64_t h = h_begin; h < h_end; h++)
+            {
+                float *out_head = out + (h - h_begin) * out_head_stride;
+                const float *xr = x_row + h * D;
+                const float *wr = w_row + h * D;
+#pragma omp simd
+                for (int64_t d = 0; d < D; d++)
+                {
+                    out_head[d] += wr[d] * xr[d];
+                }
+            }
+        }
+    });
+}
+
+// Funkcja: spmm_lowrank_partitioned
+// result[row,h,d] = ∑_e (∑_r coef[e,h,r] * basis[h,r,d]) * x[col(e),h,d]
+inline void spmm_lowrank_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const LowRankInput &in,
+    float *result)
+{
+    const int64_t H = in.H;
+    const int64_t R = in.R;
+    const int64_t D = in.D;
+    NodeMajorLayout layout{H, D};
+
+    // bufor coef [H*R] na wątek (tylko przy edge_attr)
+    std::vector<float> coef_buf(in.proj ? omp_get_max_threads() * H * R : 0);
+    spmm_stats::record_alloc(static_cast<int64_t>(coef_buf.size() * sizeof(float)));
+
+    spmm_partitioned_rows(part, indptr, H, D, result, layout, H,
+                          [&](int64_t begin, int64_t end, int64_t h_begin, int64_t h_end, float *out, int64_t out_head_stride)
+    {
+        float *buf = in.proj ? coef_buf.data() + omp_get_thread_num() * H * R : nullptr;
+
+        for (int64_t h = h_begin; h < h_end; h++)
+        {
+            float *out_head = out + (h - h_begin) * out_head_stride;
+            std::fill(out_head, out_head + D, 0.0f);
+        }
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            const float *x_row = in.x + in.indices[i] * H * D;
+            const float *c = lowrank_edge_coef(in, i, buf);
+
+            for (int64_t h = h_begin; h < h_end; h++)
+            {
+                float *out_head = out + (h - h_begin) * out_head_stride;
+                const float *xr = x_row + h * D;
+                const float *ch = c + h * R;
+                const float *bh = in.basis + h * R * D;
+#pragma omp simd
+                for (int64_t d = 0; d < D; d++)
+                {
+                    float w = 0.0f;
+                    for (int64_t r = 0; r < R; r++)
+                    {
+                        w += ch[r] * bh[r * D + d];
+                    }
+                    out_head[d] += w * xr[d];
+                }
+            }
+        }
+    });
+}
+
+// Funkcja: channel_backward_weights
+// grad_weights[e,h,d] = grad_out[row(e),h,d] * x[col(e),h,d]
+inline void channel_backward_weights(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const ChannelInput &in,
+    const float *grad_out,
+    float *grad_weights)
+{
+    const int64_t HD = in.H * in.D;
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < part.num_parts(); p++)
+    {
+        spmm_stats::BusyScope busy(op);
+        part.for_each_segment(p, indptr, [&](int64_t, int64_t row, int64_t begin, int64_t end, bool)
+        {
+            const float *g_row = grad_out + row * HD;
+            for (int64_t i = begin; i < end; i++)
+            {
+                const float *x_row = in.x + in.indices[i] * HD;
+                float *gw = grad_weights + i * HD;
+#pragma omp simd
+                for (int64_t k = 0; k < HD; k++)
+                {
+                    gw[k] = g_row[k] * x_row[k];
+                }
+            }
+        });
+    }
+}
+
+// Funkcja: lowrank_backward_edges
+// Jedno przejście po krawędziach dla gradientów wag niskiego rzędu:
+//   grad_coef[e,h,r]  = ∑_d basis[h,r,d] * grad_out[row,h,d] * x[col,h,d]
+//   grad_basis[h,r,d] = ∑_e coef[e,h,r] * grad_out[row,h,d] * x[col,h,d]
+// grad_basis sumowany jest w buforach wątków i redukowany na końcu.
+// Przy edge_attr grad_coef [E,H,R] jest potrzebny jawnie (gradienty
+// edge_attr i proj to mnożenia macierzy), więc to jedyny tensor krawędziowy.
+// grad_coef / grad_basis mogą być nullptr.
+inline void lowrank_backward_edges(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const LowRankInput &in,
+    const float *grad_out,
+    float *grad_coef,
+    float *grad_basis)
+{
+    const int64_t H = in.H;
+    const int64_t R = in.R;
+    const int64_t D = in.D;
+    const int64_t HRD = H * R * D;
+    const int64_t T = omp_get_max_threads();
+
+    std::vector<float> coef_buf(in.proj ? T * H * R : 0);
+    std::vector<float> basis_acc(grad_basis ? T * HRD : 0, 0.0f);
+    spmm_stats::record_alloc(static_cast<int64_t>((coef_buf.size() + basis_acc.size()) * sizeof(float)));
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < part.num_parts(); p++)
+    {
+        spmm_stats::BusyScope busy(op);
+        const int64_t t = omp_get_thread_num();
+        float *buf = in.proj ? coef_buf.data() + t * H * R : nullptr;
+        float *acc = grad_basis ? basis_acc.data() + t * HRD : nullptr;
+
+        part.for_each_segment(p, indptr, [&](int64_t, int64_t row, int64_t begin, int64_t end, bool)
+        {
+            for (int64_t i = begin; i < end; i++)
+            {
+                const float *x_row = in.x + in.indices[i] * H * D;
+                const float *g_row = grad_out + row * H * D;
+                const float *c = acc ? lowrank_edge_coef(in, i, buf) : nullptr;
+
+                for (int64_t h = 0; h < H; h++)
+                {
+                    const float *xr = x_row + h * D;
+                    const float *gr = g_row + h * D;
+
+                    for (int64_t r = 0; r < R; r++)
+                    {
+                        const float *br = in.basis + (h * R + r) * D;
+                        if (grad_coef)
+                        {
+                            float s = 0.0f;
+#pragma omp simd reduction(+ : s)
+                            for (int64_t d = 0; d < D; d++)
+                            {
+                                s += br[d] * gr[d] * xr[d];
+                            }
+                            grad_coef[(i * H + h) * R + r] = s;
+                        }
+                        if (acc)
+                        {
+                            const float cr = c[h * R + r];
+                            float *ar = acc + (h * R + r) * D;
+#pragma omp simd
+                            for (int64_t d = 0; d < D; d++)
+                            {
+                                ar[d] += cr * gr[d] * xr[d];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    if (grad_basis)
+    {
+        std::fill(grad_basis, grad_basis + HRD, 0.0f);
+        for (int64_t t = 0; t < T; t++)
+        {
+            const float *a = basis_acc.data() + t * HRD;
+            for (int64_t k = 0; k < HRD; k++)
+            {
+                grad_basis[k] += a[k];
+            }
+        }
+    }
+}
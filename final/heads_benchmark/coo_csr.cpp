@@ -0,0 +1,144 @@
+#include "spmm_extension.h"
+#include "coo_csr.h"
+
+// Funkcja: coo_to_csr
+// Buduje CSR grafu o num_nodes węzłach z listy krawędzi COO (row, col)
+// równoległym sortowaniem przez zliczanie (coo_csr.h), bez torch.argsort.
+//
+// Sortowanie jest dwuprzebiegowe (LSD): najpierw stabilnie po col, potem
+// stabilnie po row, więc w każdym wierszu kolumny są rosnące.
+//
+// Opcje:
+//   merge_duplicates - powtórzone krawędzie (row, col) są scalane w jedną,
+//                      wartości są sumowane,
+//   add_self_loops   - węzły bez pętli własnej dostają krawędź (i, i)
+//                      z wartością self_loop_value,
+//   with_csc         - dodatkowo transpozycja wyniku (csr_transpose).
+//
+// Zwraca [indptr, indices, values, perm, t_indptr, t_rows, t_perm]:
+//   values - values[perm] (albo suma grupy po scaleniu); None bez values,
+//   perm   - dla każdej krawędzi wyniku numer (pierwszej) krawędzi
+//            wejściowej, -1 dla dodanych pętli własnych,
+//   t_*    - jak w csr_transpose; None bez with_csc.
+
+std::vector<torch::Tensor> coo_to_csr(
+    torch::Tensor row,
+    torch::Tensor col,
+    c10::optional<torch::Tensor> values,
+    int64_t num_nodes,
+    bool with_csc,
+    bool merge_duplicates,
+    bool add_self_loops,
+    double self_loop_value)
+{
+    TORCH_CHECK(row.dim() == 1 && col.dim() == 1, "row and col must be 1D");
+    TORCH_CHECK(row.size(0) == col.size(0), "row and col must have the same length");
+    TORCH_CHECK(row.scalar_type() == torch::kInt64 && col.scalar_type() == torch::kInt64,
+                "row and col must be int64");
+    TORCH_CHECK(num_nodes >= 0, "num_nodes must be non-negative");
+
+    row = row.contiguous();
+    col = col.contiguous();
+    int64_t E = row.size(0);
+    if (E > 0)
+    {
+        TORCH_CHECK(row.min().item<int64_t>() >= 0 && row.max().item<int64_t>() < num_nodes,
+                    "row index out of range [0, num_nodes)");
+        TORCH_CHECK(col.min().item<int64_t>() >= 0 && col.max().item<int64_t>() < num_nodes,
+                    "col index out of range [0, num_nodes)");
+    }
+    if (values)
+    {
+        TORCH_CHECK(values->size(0) == E, "values first dim must match number of edges");
+    }
+
+    // pętle własne dopisywane na końcu listy krawędzi (numery E, E+1, ...)
+    torch::Tensor loops;
+    if (add_self_loops)
+    {
+        std::vector<char> has_loop(num_nodes, 0);
+        auto row_ptr = row.data_ptr<int64_t>();
+        auto col_ptr = col.data_ptr<int64_t>();
+        for (int64_t i = 0; i < E; i++)
+        {
+            if (row_ptr[i] == col_ptr[i])
+            {
+                has_loop[row_ptr[i]] = 1;
+            }
+        }
+
+        std::vector<int64_t> missing;
+        for (int64_t n = 0; n < num_nodes; n++)
+        {
+            if (!has_loop[n])
+            {
+                missing.push_back(n);
+            }
+        }
+        loops = torch::tensor(missing, row.options());
+        row = torch::cat({row, loops});
+        col = torch::cat({col, loops});
+    }
+    int64_t E_all = row.size(0);
+
+    auto opts = row.options();
+    auto by_col = torch::empty({E_all}, opts);
+    auto col_ptr_tmp = torch::empty({num_nodes + 1}, opts);
+    auto indptr = torch::empty({num_nodes + 1}, opts);
+    auto perm = torch::empty({E_all}, opts);
+
+    stable_counting_sort(col.data_ptr<int64_t>(), nullptr, E_all, num_nodes,
+                         col_ptr_tmp.data_ptr<int64_t>(), by_col.data_ptr<int64_t>());
+    stable_counting_sort(row.data_ptr<int64_t>(), by_col.data_ptr<int64_t>(), E_all, num_nodes,
+                         indptr.data_ptr<int64_t>(), perm.data_ptr<int64_t>());
+    auto indices = col.index_select(0, perm);
+
+    torch::Tensor out_values;
+    if (values)
+    {
+        auto values_all = *values;
+        if (add_self_loops)
+        {
+            auto shape = values_all.sizes().vec();
+            shape[0] = loops.size(0);
+            values_all = torch::cat({values_all, torch::full(shape, self_loop_value, values_all.options())});
+        }
+        out_values = values_all.index_select(0, perm);
+    }
+
+    if (merge_duplicates)
+    {
+        auto new_indptr = torch::empty({num_nodes + 1}, opts);
+        auto slot = torch::empty({E_all}, opts);
+        std::vector<int64_t> first;
+        csr_unique_segments(indptr.data_ptr<int64_t>(), indices.data_ptr<int64_t>(), num_nodes,
+                            new_indptr.data_ptr<int64_t>(), slot.data_ptr<int64_t>(), first);
+
+        auto first_t = torch::tensor(first, opts);
+        indptr = new_indptr;
+        indices = indices.index_select(0, first_t);
+        perm = perm.index_select(0, first_t);
+        if (values)
+        {
+            auto shape = out_values.sizes().vec();
+            shape[0] = first_t.size(0);
+            out_values = torch::zeros(shape, out_values.options()).index_add_(0, slot, out_values);
+        }
+    }
+
+    if (add_self_loops)
+    {
+        perm.masked_fill_(perm >= E, -1);
+    }
+
+    std::vector<torch::Tensor> result = {indptr, indices, out_values, perm,
+                                         torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    if (with_csc)
+    {
+        auto t = csr_transpose(indices, indptr, num_nodes);
+        result[4] = t[0];
+        result[5] = t[1];
+        result[6] = t[2];
+    }
+    return result;
+}
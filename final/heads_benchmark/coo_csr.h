@@ -0,0 +1,148 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Minimalny kawałek elementów na wątek i limit liczników histogramów
+// w stable_counting_sort (1 << 24 liczników = 128 MB).
+constexpr int64_t kSortChunk = 1 << 16;
+constexpr int64_t kSortHistogramEntries = 1 << 24;
+
+// Funkcja: stable_counting_sort
+// Równoległe, stabilne sortowanie przez zliczanie elementów po kluczu.
+//
+// Elementy to order[0..E) (albo 0..E-1 gdy order == nullptr), kluczem
+// elementu e jest keys[e] z zakresu [0, num_keys). Wynik:
+//   ptr [num_keys+1] - ptr[k] to pozycja pierwszego elementu o kluczu k,
+//   perm [E]         - elementy posortowane po kluczu; elementy o tym samym
+//                      kluczu zachowują kolejność z order.
+//
+// Elementy dzielone są na ciągłe kawałki po jednym na wątek. Każdy wątek
+// liczy własny histogram, potem dla każdego klucza suma prefiksowa po
+// wątkach daje przesunięcie kawałka w obrębie klucza, a na końcu każdy wątek
+// rozrzuca swoje elementy. Liczba kawałków wynika z samego E (kawałek to
+// co najmniej kSortChunk elementów); num_keys ogranicza ją tylko przez
+// pamięć histogramów (kawałki * num_keys liczników), która nie przekracza
+// max(2 * E, kSortHistogramEntries).
+inline void stable_counting_sort(
+    const int64_t *keys,
+    const int64_t *order,
+    int64_t E,
+    int64_t num_keys,
+    int64_t *ptr,
+    int64_t *perm)
+{
+    const int64_t hist_limit = std::max<int64_t>(2 * E, kSortHistogramEntries) / std::max<int64_t>(num_keys, 1);
+    const int64_t T = std::max<int64_t>(1, std::min<int64_t>({int64_t(omp_get_max_threads()), E / kSortChunk, hist_limit}));
+    std::vector<int64_t> hist(T * num_keys, 0);
+
+    auto chunk_begin = [&](int64_t t) { return E * t / T; };
+    auto element = [&](int64_t i) { return order ? order[i] : i; };
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t t = 0; t < T; t++)
+    {
+        int64_t *h = hist.data() + t * num_keys;
+        for (int64_t i = chunk_begin(t); i < chunk_begin(t + 1); i++)
+        {
+            h[keys[element(i)]]++;
+        }
+    }
+
+    // hist[t][k] := liczba elementów o kluczu k w kawałkach 0..t-1
+#pragma omp parallel for schedule(static)
+    for (int64_t k = 0; k < num_keys; k++)
+    {
+        int64_t sum = 0;
+        for (int64_t t = 0; t < T; t++)
+        {
+            int64_t count = hist[t * num_keys + k];
+            hist[t * num_keys + k] = sum;
+            sum += count;
+        }
+        ptr[k + 1] = sum;
+    }
+
+    ptr[0] = 0;
+    for (int64_t k = 0; k < num_keys; k++)
+    {
+        ptr[k + 1] += ptr[k];
+    }
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t t = 0; t < T; t++)
+    {
+        int64_t *h = hist.data() + t * num_keys;
+        for (int64_t i = chunk_begin(t); i < chunk_begin(t + 1); i++)
+        {
+            int64_t e = element(i);
+            int64_t k = keys[e];
+            perm[ptr[k] + h[k]++] = e;
+        }
+    }
+}
+
+// Funkcja: csr_row_of_edge
+// row_of[i] = wiersz krawędzi i (rozwinięcie indptr do COO).
+inline void csr_row_of_edge(const int64_t *indptr, int64_t num_rows, int64_t *row_of)
+{
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        std::fill(row_of + indptr[row], row_of + indptr[row + 1], row);
+    }
+}
+
+// Funkcja: csr_unique_segments
+// Dla CSR z posortowanymi kolumnami w wierszach wyznacza scalenie
+// powtarzających się krawędzi (row, col):
+//   new_indptr [num_rows+1] - indptr po scaleniu,
+//   slot [E]                - numer krawędzi wynikowej dla każdej krawędzi,
+//   first [E_out]           - pierwsza krawędź wejściowa każdej grupy.
+// first jest zmieniany rozmiarem do liczby krawędzi po scaleniu.
+inline void csr_unique_segments(
+    const int64_t *indptr,
+    const int64_t *indices,
+    int64_t num_rows,
+    int64_t *new_indptr,
+    int64_t *slot,
+    std::vector<int64_t> &first)
+{
+    new_indptr[0] = 0;
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        int64_t unique = 0;
+        for (int64_t i = indptr[row]; i < indptr[row + 1]; i++)
+        {
+            if (i == indptr[row] || indices[i] != indices[i - 1])
+            {
+                unique++;
+            }
+        }
+        new_indptr[row + 1] = unique;
+    }
+
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        new_indptr[row + 1] += new_indptr[row];
+    }
+    first.resize(new_indptr[num_rows]);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        int64_t out = new_indptr[row] - 1;
+        for (int64_t i = indptr[row]; i < indptr[row + 1]; i++)
+        {
+            if (i == indptr[row] || indices[i] != indices[i - 1])
+            {
+                first[++out] = i;
+            }
+            slot[i] = out;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "spmm_extension.h"
+
+std::shared_ptr<CSRGraph> CSRGraph::build(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    int64_t num_cols,
+    int64_t num_parts,
+    c10::optional<torch::Tensor> perm)
+{
+    TORCH_CHECK(indptr.dim() == 1 && indptr.size(0) >= 1, "indptr must be 1D with at least one element");
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.scalar_type() == torch::kInt64 && indices.scalar_type() == torch::kInt64,
+                "indptr and indices must be int64");
+
+    auto graph = std::make_shared<CSRGraph>();
+    graph->indptr = indptr.contiguous();
+    graph->indices = indices.contiguous();
+    graph->num_rows = indptr.size(0) - 1;
+    graph->num_cols = num_cols < 0 ? graph->num_rows : num_cols;
+    graph->nnz = indices.size(0);
+
+    auto indptr_ptr = graph->indptr.data_ptr<int64_t>();
+    TORCH_CHECK(indptr_ptr[0] == 0 && indptr_ptr[graph->num_rows] == graph->nnz,
+                "indptr must start at 0 and end at the number of edges");
+    auto degree = graph->indptr.narrow(0, 1, graph->num_rows) - graph->indptr.narrow(0, 0, graph->num_rows);
+    if (graph->num_rows > 0)
+    {
+        TORCH_CHECK(degree.min().item<int64_t>() >= 0, "indptr must be non-decreasing");
+    }
+    if (graph->nnz > 0)
+    {
+        TORCH_CHECK(graph->indices.min().item<int64_t>() >= 0 && graph->indices.max().item<int64_t>() < graph->num_cols,
+                    "indices out of range [0, num_cols)");
+    }
+
+    auto t = csr_transpose(graph->indices, graph->indptr, graph->num_cols);
+    graph->t_indptr = t[0];
+    graph->t_rows = t[1];
+    graph->t_perm = t[2];
+
+    graph->partition = make_partition(graph->indptr, num_parts);
+    graph->partition_t = make_partition(graph->t_indptr, num_parts);
+
+    graph->out_degree = degree;
+    graph->in_degree = graph->t_indptr.narrow(0, 1, graph->num_cols) - graph->t_indptr.narrow(0, 0, graph->num_cols);
+    graph->max_out_degree = graph->num_rows > 0 ? graph->out_degree.max().item<int64_t>() : 0;
+    graph->max_in_degree = graph->num_cols > 0 ? graph->in_degree.max().item<int64_t>() : 0;
+    graph->mean_degree = graph->num_rows > 0 ? double(graph->nnz) / double(graph->num_rows) : 0.0;
+
+    if (perm)
+    {
+        TORCH_CHECK(perm->dim() == 1 && perm->size(0) == graph->num_rows && perm->scalar_type() == torch::kInt64,
+                    "perm must be int64 [num_rows]");
+        if (graph->num_rows > 0)
+        {
+            TORCH_CHECK(perm->min().item<int64_t>() >= 0 && perm->max().item<int64_t>() < graph->num_rows,
+                        "perm must be a permutation of [0, num_rows)");
+        }
+        graph->perm = perm->contiguous();
+        graph->inv_perm = torch::empty_like(graph->perm);
+        graph->inv_perm.index_put_({graph->perm}, torch::arange(graph->num_rows, graph->perm.options()));
+        TORCH_CHECK(graph->inv_perm.index_select(0, graph->perm).equal(torch::arange(graph->num_rows, graph->perm.options())),
+                    "perm must be a permutation of [0, num_rows)");
+    }
+
+    return graph;
+}
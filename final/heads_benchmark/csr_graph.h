@@ -0,0 +1,58 @@
+#pragma once
+
+#include <torch/extension.h>
+#include <memory>
+
+#include "csr_partition.h"
+
+// Struktura: CSRGraph
+// Skompilowany, niezmienny graf CSR budowany raz (np. przy ładowaniu danych)
+// i przekazywany do operacji rozszerzenia zamiast pary (indices, indptr).
+//
+// Przy budowie wejście jest sprawdzane raz (typy, kształty, monotoniczność
+// indptr, zakres indices) i od razu liczone są:
+//   - transpozycja CSC (t_indptr, t_rows, t_perm jak w csr_transpose),
+//   - podziały merge-path dla CSR i CSC,
+//   - stopnie wierzchołków i ich statystyki.
+// Operacje przyjmujące CSRGraph nie sprawdzają już wzorca, a backward używa
+// gotowej transpozycji zamiast liczyć ją przy każdym wywołaniu.
+//
+// perm/inv_perm to opcjonalne przenumerowanie wierzchołków (perm[new] = old),
+// w którym zapisany jest graf; puste, gdy graf ma oryginalną numerację.
+// edge_perm[new_e] = old_e ustawia reorder_graph (reorder.cpp).
+
+struct CSRGraph
+{
+    int64_t num_rows = 0;
+    int64_t num_cols = 0;
+    int64_t nnz = 0;
+
+    torch::Tensor indptr;  // [num_rows+1]
+    torch::Tensor indices; // [nnz]
+
+    torch::Tensor t_indptr; // [num_cols+1]
+    torch::Tensor t_rows;   // [nnz]
+    torch::Tensor t_perm;   // [nnz]
+
+    CsrPartition partition;
+    CsrPartition partition_t;
+
+    torch::Tensor out_degree; // [num_rows]
+    torch::Tensor in_degree;  // [num_cols]
+    int64_t max_out_degree = 0;
+    int64_t max_in_degree = 0;
+    double mean_degree = 0.0;
+
+    torch::Tensor perm;
+    torch::Tensor inv_perm;
+    torch::Tensor edge_perm;
+
+    // num_cols < 0 oznacza graf kwadratowy (num_cols = num_rows),
+    // num_parts <= 0 - liczbę wątków OpenMP
+    static std::shared_ptr<CSRGraph> build(
+        torch::Tensor indptr,
+        torch::Tensor indices,
+        int64_t num_cols,
+        int64_t num_parts,
+        c10::optional<torch::Tensor> perm);
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Struktura: CsrPartition
+// Podział pracy CSR metodą merge-path (Merrill & Garland): cała praca to
+// num_rows + nnz kroków (koniec wiersza lub krawędź), dzielona na num_parts
+// równych odcinków. Odcinek p zaczyna się w wierszu row_start[p] na krawędzi
+// edge_start[p], więc wiersz-hub może zostać podzielony między kilka części.
+//
+// Każdy wiersz kończy się w dokładnie jednej części - ta część zapisuje wynik
+// wiersza. Początek wiersza policzony przez poprzednią część trafia do bufora
+// "carry" i jest dodawany szeregowo, w kolejności części, po pętli równoległej.
+// Dla danego podziału wynik jest więc deterministyczny i wolny od wyścigów.
+//
+// Podział zależy tylko od indptr, więc buduje się go raz na graf.
+
+struct CsrPartition
+{
+    int64_t num_rows = 0;
+    int64_t nnz = 0;
+    std::vector<int64_t> row_start;  // [num_parts+1]
+    std::vector<int64_t> edge_start; // [num_parts+1]
+
+    int64_t num_parts() const
+    {
+        return static_cast<int64_t>(row_start.size()) - 1;
+    }
+
+    static CsrPartition build(const int64_t *indptr, int64_t num_rows, int64_t num_parts)
+    {
+        CsrPartition part;
+        part.num_rows = num_rows;
+        part.nnz = indptr[num_rows];
+        num_parts = std::max<int64_t>(num_parts, 1);
+        part.row_start.resize(num_parts + 1);
+        part.edge_start.resize(num_parts + 1);
+
+        int64_t total = num_rows + part.nnz;
+        for (int64_t p = 0; p <= num_parts; p++)
+        {
+            int64_t diagonal = total * p / num_parts;
+
+            // wyszukiwanie binarne punktu przecięcia przekątnej ze ścieżką
+            int64_t lo = std::max<int64_t>(diagonal - part.nnz, 0);
+            int64_t hi = std::min<int64_t>(diagonal, num_rows);
+            while (lo < hi)
+            {
+                int64_t pivot = (lo + hi) / 2;
+                if (indptr[pivot + 1] <= diagonal - pivot - 1)
+                {
+                    lo = pivot + 1;
+                }
+                else
+                {
+                    hi = pivot;
+                }
+            }
+            part.row_start[p] = lo;
+            part.edge_start[p] = diagonal - lo;
+        }
+
+        return part;
+    }
+
+    // Wywołuje fn(p, row, begin, end, row_ends_here) dla każdego fragmentu
+    // wiersza w części p (w kolejności). row_ends_here == false oznacza
+    // ostatni, niedokończony fragment części - to jest carry dla wiersza row.
+    template <typename Fn>
+    void for_each_segment(int64_t p, const int64_t *indptr, Fn &&fn) const
+    {
+        int64_t e = edge_start[p];
+        for (int64_t row = row_start[p]; row < row_start[p + 1]; row++)
+        {
+            int64_t end = indptr[row + 1];
+            fn(p, row, e, end, true);
+            e = end;
+        }
+
+        int64_t row = row_start[p + 1];
+        if (row < num_rows && e < edge_start[p + 1])
+        {
+            fn(p, row, e, edge_start[p + 1], false);
+        }
+    }
+};
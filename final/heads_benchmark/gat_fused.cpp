@@ -0,0 +1,319 @@
+#include "spmm_extension.h"
+#include <omp.h>
+#include <cmath>
+#include <limits>
+
+// Funkcja: gat_fused_csr
+// Cała warstwa uwagi GAT w jednym przejściu po CSR (wiersz = węzeł docelowy i,
+// indices = sąsiedzi źródłowi j):
+//
+// e[k,h]     = LeakyReLU(alpha_src[j,h] + alpha_dst[i,h])
+// att[k,h]   = softmax_{k w wierszu i}(e[k,h])
+// out[i,h,:] = ∑_k att[k,h] * x_proj[j,h,:]
+//
+// indices: [E], indptr: [N+1], alpha_src/alpha_dst: [N,H], x_proj: [N,H,D]
+//
+// Softmax liczony jest "online" (bieżące maksimum i suma, akumulator
+// przeskalowywany przy zmianie maksimum), więc att nigdy nie trafia do pamięci
+// jako tensor [E,H]. Do backwardu zapisujemy tylko max i sumę na (wiersz, head).
+
+static const float kSoftmaxEps = 1e-16f;
+
+static inline float leaky_relu(float x, float negative_slope)
+{
+    return x > 0.0f ? x : x * negative_slope;
+}
+
+static void gat_fused_forward_kernel(
+    const int64_t *indices_ptr,
+    const int64_t *indptr_ptr,
+    const float *alpha_src_ptr,
+    const float *alpha_dst_ptr,
+    const float *x_ptr,
+    float *out_ptr,
+    float *max_ptr,
+    float *sum_ptr,
+    int64_t num_rows,
+    int64_t H,
+    int64_t D,
+    float negative_slope)
+{
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        float *out_row = out_ptr + row * H * D;
+        float *m = max_ptr + row * H;
+        float *s = sum_ptr + row * H;
+        const float *a_dst = alpha_dst_ptr + row * H;
+
+        for (int64_t h = 0; h < H; h++)
+        {
+            m[h] = -std::numeric_limits<float>::infinity();
+            s[h] = 0.0f;
+        }
+
+        for (int64_t i = indptr_ptr[row]; i < indptr_ptr[row + 1]; i++)
+        {
+            int64_t col = indices_ptr[i];
+            const float *in_row = x_ptr + col * H * D;
+            const float *a_src = alpha_src_ptr + col * H;
+
+            for (int64_t h = 0; h < H; h++)
+            {
+                float e = leaky_relu(a_src[h] + a_dst[h], negative_slope);
+                float *acc = out_row + h * D;
+
+                if (e > m[h])
+                {
+                    // nowe maksimum - przeskalowanie tego, co już zsumowane
+                    float scale = std::exp(m[h] - e);
+                    s[h] *= scale;
+                    for (int64_t d = 0; d < D; d++)
+                    {
+                        acc[d] *= scale;
+                    }
+                    m[h] = e;
+                }
+
+                float p = std::exp(e - m[h]);
+                s[h] += p;
+                for (int64_t d = 0; d < D; d++)
+                {
+                    acc[d] += p * in_row[h * D + d];
+                }
+            }
+        }
+
+        for (int64_t h = 0; h < H; h++)
+        {
+            float inv = 1.0f / (s[h] + kSoftmaxEps);
+            float *acc = out_row + h * D;
+            for (int64_t d = 0; d < D; d++)
+            {
+                acc[d] *= inv;
+            }
+        }
+    }
+}
+
+// Backward (g = grad_out, a = att odtworzone z zapisanego max/sum):
+// de[k,h]   = a[k,h] * (<g[i,h,:], x_proj[j,h,:]> - <g[i,h,:], out[i,h,:]>)
+// dpre[k,h] = de[k,h] * LeakyReLU'(alpha_src[j,h] + alpha_dst[i,h])
+// grad_alpha_dst[i,h] = ∑_{k w wierszu i} dpre[k,h]        - przejście po wierszach
+// grad_alpha_src[j,h] = ∑_{k z kolumną j} dpre[k,h]        - przejście po CSC
+// grad_x_proj[j,h,:]  = ∑_{k z kolumną j} a[k,h] * g[i,h,:] - przejście po CSC
+// Wartości na krawędź liczone są w locie w obu przejściach, bez buforów [E,H].
+// Z CSRGraph transpozycja do przejścia po CSC jest brana z grafu.
+
+class GatFusedCsrFunction : public torch::autograd::Function<GatFusedCsrFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor alpha_src,
+        torch::Tensor alpha_dst,
+        torch::Tensor x_proj,
+        double negative_slope,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(x_proj.dim() == 3, "x_proj must be 3D [N,H,D]");
+        TORCH_CHECK(alpha_src.dim() == 2 && alpha_dst.dim() == 2, "alpha_src/alpha_dst must be 2D [N,H]");
+
+        int64_t num_rows = indptr.size(0) - 1;
+        int64_t H = x_proj.size(1);
+        int64_t D = x_proj.size(2);
+        TORCH_CHECK(alpha_src.size(0) == x_proj.size(0) && alpha_src.size(1) == H,
+                    "alpha_src must be [N,H] matching x_proj");
+        TORCH_CHECK(alpha_dst.size(0) == num_rows && alpha_dst.size(1) == H,
+                    "alpha_dst must be [num_rows,H]");
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        alpha_src = alpha_src.contiguous();
+        alpha_dst = alpha_dst.contiguous();
+        x_proj = x_proj.contiguous();
+
+        SPMM_OP_SCOPE(op, "gat_fused_forward", indices, indptr, alpha_src, alpha_dst, x_proj);
+        op.work(indices.size(0), spmm_stats::spmm_bytes(num_rows, indices.size(0), H, D, 4) - 4 * indices.size(0) * H);
+
+        auto out = torch::zeros({num_rows, H, D}, x_proj.options());
+        auto row_max = torch::empty({num_rows, H}, x_proj.options());
+        auto row_sum = torch::empty({num_rows, H}, x_proj.options());
+        op.alloc(out.nbytes() + row_max.nbytes() + row_sum.nbytes());
+
+        gat_fused_forward_kernel(
+            indices.data_ptr<int64_t>(), indptr.data_ptr<int64_t>(),
+            alpha_src.data_ptr<float>(), alpha_dst.data_ptr<float>(),
+            x_proj.data_ptr<float>(), out.data_ptr<float>(),
+            row_max.data_ptr<float>(), row_sum.data_ptr<float>(),
+            num_rows, H, D, static_cast<float>(negative_slope));
+
+        torch::Tensor t_indptr, t_rows;
+        if (graph)
+        {
+            t_indptr = graph->t_indptr;
+            t_rows = graph->t_rows;
+        }
+
+        ctx->save_for_backward({indices, indptr, alpha_src, alpha_dst, x_proj, out, row_max, row_sum, t_indptr, t_rows});
+        ctx->saved_data["negative_slope"] = negative_slope;
+        return out;
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto alpha_src = saved[2];
+        auto alpha_dst = saved[3];
+        auto x_proj = saved[4];
+        auto out = saved[5];
+        auto row_max = saved[6];
+        auto row_sum = saved[7];
+        float negative_slope = static_cast<float>(ctx->saved_data["negative_slope"].toDouble());
+        auto grad_out = grad_outputs[0].contiguous();
+
+        int64_t num_rows = indptr.size(0) - 1;
+        int64_t num_cols = x_proj.size(0);
+        int64_t H = x_proj.size(1);
+        int64_t D = x_proj.size(2);
+
+        SPMM_OP_SCOPE(op, "gat_fused_backward", indices, indptr, grad_out);
+        // dwa przejścia (CSR i CSC), w każdym odczyt x_proj[col] i grad_out[row] na krawędź
+        op.work(indices.size(0), 2 * spmm_stats::spmm_bytes(num_rows, indices.size(0), H, D, 4));
+
+        auto grad_alpha_src = torch::zeros({num_cols, H}, x_proj.options());
+        auto grad_alpha_dst = torch::zeros({num_rows, H}, x_proj.options());
+        auto grad_x_proj = torch::zeros({num_cols, H, D}, x_proj.options());
+        auto g_dot_out = torch::empty({num_rows, H}, x_proj.options());
+        op.alloc(grad_alpha_src.nbytes() + grad_alpha_dst.nbytes() + grad_x_proj.nbytes() + g_dot_out.nbytes());
+
+        auto indices_ptr = indices.data_ptr<int64_t>();
+        auto indptr_ptr = indptr.data_ptr<int64_t>();
+        auto alpha_src_ptr = alpha_src.data_ptr<float>();
+        auto alpha_dst_ptr = alpha_dst.data_ptr<float>();
+        auto x_ptr = x_proj.data_ptr<float>();
+        auto out_ptr = out.data_ptr<float>();
+        auto max_ptr = row_max.data_ptr<float>();
+        auto sum_ptr = row_sum.data_ptr<float>();
+        auto g_ptr = grad_out.data_ptr<float>();
+        auto g_dot_out_ptr = g_dot_out.data_ptr<float>();
+        auto grad_alpha_src_ptr = grad_alpha_src.data_ptr<float>();
+        auto grad_alpha_dst_ptr = grad_alpha_dst.data_ptr<float>();
+        auto grad_x_ptr = grad_x_proj.data_ptr<float>();
+
+        // wkład krawędzi (row -> col) do dpre dla heada h; zwraca też att
+        auto edge_grad = [&](int64_t row, int64_t col, int64_t h, float &att) -> float
+        {
+            float pre = alpha_src_ptr[col * H + h] + alpha_dst_ptr[row * H + h];
+            float e = leaky_relu(pre, negative_slope);
+            att = std::exp(e - max_ptr[row * H + h]) / (sum_ptr[row * H + h] + kSoftmaxEps);
+
+            const float *g_row = g_ptr + row * H * D + h * D;
+            const float *in_row = x_ptr + col * H * D + h * D;
+            float dot = 0.0f;
+            for (int64_t d = 0; d < D; d++)
+            {
+                dot += g_row[d] * in_row[d];
+            }
+            float de = att * (dot - g_dot_out_ptr[row * H + h]);
+            return pre > 0.0f ? de : de * negative_slope;
+        };
+
+        // przejście po wierszach: <g, out> oraz grad_alpha_dst
+#pragma omp parallel for schedule(dynamic, 64)
+        for (int64_t row = 0; row < num_rows; row++)
+        {
+            for (int64_t h = 0; h < H; h++)
+            {
+                const float *g_row = g_ptr + row * H * D + h * D;
+                const float *o_row = out_ptr + row * H * D + h * D;
+                float dot = 0.0f;
+                for (int64_t d = 0; d < D; d++)
+                {
+                    dot += g_row[d] * o_row[d];
+                }
+                g_dot_out_ptr[row * H + h] = dot;
+            }
+
+            for (int64_t i = indptr_ptr[row]; i < indptr_ptr[row + 1]; i++)
+            {
+                int64_t col = indices_ptr[i];
+                for (int64_t h = 0; h < H; h++)
+                {
+                    float att;
+                    grad_alpha_dst_ptr[row * H + h] += edge_grad(row, col, h, att);
+                }
+            }
+        }
+
+        // przejście po kolumnach (CSC): grad_alpha_src i grad_x_proj
+        if (ctx->needs_input_grad(2) || ctx->needs_input_grad(4))
+        {
+            auto t_indptr = saved[8];
+            auto t_rows = saved[9];
+            if (!t_indptr.defined())
+            {
+                auto t = csr_transpose(indices, indptr, num_cols);
+                t_indptr = t[0];
+                t_rows = t[1];
+            }
+            auto t_indptr_ptr = t_indptr.data_ptr<int64_t>();
+            auto t_rows_ptr = t_rows.data_ptr<int64_t>();
+
+#pragma omp parallel for schedule(dynamic, 64)
+            for (int64_t col = 0; col < num_cols; col++)
+            {
+                float *gx_row = grad_x_ptr + col * H * D;
+
+                for (int64_t j = t_indptr_ptr[col]; j < t_indptr_ptr[col + 1]; j++)
+                {
+                    int64_t row = t_rows_ptr[j];
+                    const float *g_row = g_ptr + row * H * D;
+
+                    for (int64_t h = 0; h < H; h++)
+                    {
+                        float att;
+                        grad_alpha_src_ptr[col * H + h] += edge_grad(row, col, h, att);
+                        for (int64_t d = 0; d < D; d++)
+                        {
+                            gx_row[h * D + d] += att * g_row[h * D + d];
+                        }
+                    }
+                }
+            }
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_alpha_src, grad_alpha_dst, grad_x_proj, torch::Tensor(), torch::Tensor()};
+    }
+};
+
+torch::Tensor gat_fused_csr(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor alpha_src,
+    torch::Tensor alpha_dst,
+    torch::Tensor x_proj,
+    double negative_slope)
+{
+    return GatFusedCsrFunction::apply(indices, indptr, alpha_src, alpha_dst, x_proj, negative_slope, std::shared_ptr<CSRGraph>());
+}
+
+torch::Tensor gat_fused_csr_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor alpha_src,
+    torch::Tensor alpha_dst,
+    torch::Tensor x_proj,
+    double negative_slope)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(x_proj.dim() == 3 && x_proj.size(0) == graph->num_cols, "x_proj must be 3D [num_cols,H,D]");
+    return GatFusedCsrFunction::apply(graph->indices, graph->indptr, alpha_src, alpha_dst, x_proj, negative_slope, graph);
+}
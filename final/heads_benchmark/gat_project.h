@@ -0,0 +1,81 @@
+#pragma once
+
+#include "instrumentation.h"
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+
+// Współczynniki uwagi GAT liczone z wyniku projekcji x_proj = x @ W:
+//
+//   alpha_src[n,h] = ∑_d x_proj[n,h,d] * a_src[h,d]
+//   alpha_dst[n,h] = ∑_d x_proj[n,h,d] * a_dst[h,d]
+//
+// Samo x @ W zostaje w BLAS (at::mm), a oba współczynniki liczone są
+// w jednym przejściu po blokach wierszy x_proj: każdy wiersz jest czytany
+// raz, dla obu wektorów a naraz. W PyTorch (x_proj * a).sum(dim=2) to dla
+// każdego a zapis tymczasowego [N,H,D] i jego ponowny odczyt.
+
+constexpr int64_t kAlphaRows = 64;
+
+// Funkcja: gat_alpha_rows
+// alpha_src/alpha_dst dla wierszy [n_begin, n_end).
+inline void gat_alpha_rows(
+    const float *x_proj,
+    const float *a_src,
+    const float *a_dst,
+    int64_t H,
+    int64_t D,
+    int64_t n_begin,
+    int64_t n_end,
+    float *alpha_src,
+    float *alpha_dst)
+{
+    for (int64_t n = n_begin; n < n_end; n++)
+    {
+        const float *row = x_proj + n * H * D;
+        for (int64_t h = 0; h < H; h++)
+        {
+            const float *xh = row + h * D;
+            const float *as = a_src + h * D;
+            const float *ad = a_dst + h * D;
+            float s = 0.0f;
+            float t = 0.0f;
+#pragma omp simd reduction(+ : s, t)
+            for (int64_t d = 0; d < D; d++)
+            {
+                s += xh[d] * as[d];
+                t += xh[d] * ad[d];
+            }
+            alpha_src[n * H + h] = s;
+            alpha_dst[n * H + h] = t;
+        }
+    }
+}
+
+// Funkcja: gat_alpha
+// Bloki po kAlphaRows wierszy rozdzielane są między wątki.
+inline void gat_alpha(
+    const float *x_proj,
+    const float *a_src,
+    const float *a_dst,
+    int64_t N,
+    int64_t H,
+    int64_t D,
+    float *alpha_src,
+    float *alpha_dst)
+{
+    const int64_t blocks = (N + kAlphaRows - 1) / kAlphaRows;
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+#pragma omp parallel
+    {
+        spmm_stats::BusyScope busy(op);
+#pragma omp for schedule(static)
+        for (int64_t b = 0; b < blocks; b++)
+        {
+            int64_t n_begin = b * kAlphaRows;
+            int64_t n_end = std::min(N, n_begin + kAlphaRows);
+            gat_alpha_rows(x_proj, a_src, a_dst, H, D, n_begin, n_end, alpha_src, alpha_dst);
+        }
+    }
+}
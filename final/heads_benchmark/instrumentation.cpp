@@ -0,0 +1,41 @@
+#include "spmm_extension.h"
+
+// Funkcja: stats
+// Liczniki operacji zebrane przez spmm_stats::OpScope (instrumentation.h).
+// Dla każdej operacji:
+//   calls, time_ms, edges, bytes        - sumy po wywołaniach,
+//   alloc_bytes, max_alloc_bytes        - alokacje (wynik + bufory pomocnicze),
+//   thread_busy_ms                      - czas pracy każdego wątku OpenMP,
+//   imbalance                           - max / średnia z thread_busy_ms
+//                                         (1.0 = idealnie równy podział).
+// Bez SPMM_STATS słownik jest zawsze pusty (spmm_extension.STATS_ENABLED).
+
+py::dict stats(bool reset)
+{
+    py::dict result;
+    for (const auto &entry : spmm_stats::Registry::get().snapshot(reset))
+    {
+        const spmm_stats::OpStats &s = entry.second;
+
+        double busy_max = 0.0;
+        double busy_sum = 0.0;
+        for (double ms : s.thread_busy_ms)
+        {
+            busy_max = std::max(busy_max, ms);
+            busy_sum += ms;
+        }
+        double busy_mean = s.thread_busy_ms.empty() ? 0.0 : busy_sum / double(s.thread_busy_ms.size());
+
+        py::dict op;
+        op["calls"] = s.calls;
+        op["time_ms"] = s.time_ms;
+        op["edges"] = s.edges;
+        op["bytes"] = s.bytes;
+        op["alloc_bytes"] = s.alloc_bytes;
+        op["max_alloc_bytes"] = s.max_alloc_bytes;
+        op["thread_busy_ms"] = s.thread_busy_ms;
+        op["imbalance"] = busy_mean > 0.0 ? busy_max / busy_mean : 0.0;
+        result[py::str(entry.first)] = op;
+    }
+    return result;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Instrumentacja operacji rozszerzenia, włączana w czasie kompilacji:
+//   SPMM_STATS=1           - liczniki na operację (spmm_extension.stats()),
+//   SPMM_RECORD_FUNCTION=1 - zakresy RECORD_FUNCTION widoczne w torch.profiler
+//                            (makro SPMM_OP_SCOPE w spmm_extension.h).
+// setup.py ustawia oba makra ze zmiennych środowiskowych o tych nazwach.
+// Przy SPMM_STATS=0 (domyślnie) OpScope i BusyScope są puste, a jądra
+// kompilują się dokładnie tak jak bez instrumentacji.
+//
+// Dla każdej operacji zbierane są: liczba wywołań, łączny czas, liczba
+// przetworzonych krawędzi, szacowany ruch pamięci (ten sam model co
+// w benchmark/spmm_bench.cpp), rozmiary alokacji (wynik i bufory pomocnicze)
+// oraz czas pracy każdego wątku w częściach podziału merge-path - duża
+// różnica między wątkami wskazuje na wiersze-huby, których podział nie wyrównał.
+//
+// Czasy są "inclusive": backward_dense woła spmm_csr_3d_forward, więc jego
+// czas zawiera też czas zagnieżdżonej operacji (liczonej osobno pod swoją nazwą).
+
+#ifndef SPMM_STATS
+#define SPMM_STATS 0
+#endif
+
+namespace spmm_stats
+{
+
+struct OpStats
+{
+    int64_t calls = 0;
+    double time_ms = 0.0;
+    int64_t edges = 0;
+    int64_t bytes = 0;
+    int64_t alloc_bytes = 0;     // suma alokacji we wszystkich wywołaniach
+    int64_t max_alloc_bytes = 0; // największa suma alokacji jednego wywołania
+    std::vector<double> thread_busy_ms; // [wątek OpenMP]
+};
+
+class Registry
+{
+public:
+    static Registry &get()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    void add(const std::string &name, double time_ms, int64_t edges, int64_t bytes, int64_t alloc_bytes,
+             const std::vector<double> &busy_ms)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        OpStats &s = ops_[name];
+        s.calls++;
+        s.time_ms += time_ms;
+        s.edges += edges;
+        s.bytes += bytes;
+        s.alloc_bytes += alloc_bytes;
+        s.max_alloc_bytes = std::max(s.max_alloc_bytes, alloc_bytes);
+        if (s.thread_busy_ms.size() < busy_ms.size())
+        {
+            s.thread_busy_ms.resize(busy_ms.size(), 0.0);
+        }
+        for (size_t t = 0; t < busy_ms.size(); t++)
+        {
+            s.thread_busy_ms[t] += busy_ms[t];
+        }
+    }
+
+    std::map<std::string, OpStats> snapshot(bool reset)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, OpStats> copy = ops_;
+        if (reset)
+        {
+            ops_.clear();
+        }
+        return copy;
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, OpStats> ops_;
+};
+
+#if SPMM_STATS
+
+// Czas pracy wątku, wyrównany do linii cache, żeby wątki nie dzieliły linii.
+struct alignas(64) BusySlot
+{
+    double ms = 0.0;
+};
+
+// Pomiar jednego wywołania operacji (RAII). Jądra wywołane w trakcie
+// (spmm_partitioned_rows itp.) odnajdują bieżącą operację przez current().
+class OpScope
+{
+public:
+    explicit OpScope(const char *name)
+        : name_(name), start_(std::chrono::steady_clock::now()), busy_(omp_get_max_threads()), parent_(current())
+    {
+        current() = this;
+    }
+
+    ~OpScope()
+    {
+        current() = parent_;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+        std::vector<double> busy_ms(busy_.size());
+        for (size_t t = 0; t < busy_.size(); t++)
+        {
+            busy_ms[t] = busy_[t].ms;
+        }
+        Registry::get().add(name_, ms, edges_, bytes_, alloc_bytes_, busy_ms);
+    }
+
+    OpScope(const OpScope &) = delete;
+    OpScope &operator=(const OpScope &) = delete;
+
+    void work(int64_t edges, int64_t bytes)
+    {
+        edges_ += edges;
+        bytes_ += bytes;
+    }
+
+    void alloc(int64_t bytes) { alloc_bytes_ += bytes; }
+
+    void add_busy(double ms)
+    {
+        size_t t = static_cast<size_t>(omp_get_thread_num());
+        if (t < busy_.size())
+        {
+            busy_[t].ms += ms;
+        }
+    }
+
+    // Operacja aktywna w wątku wywołującym (nullptr poza operacją). Przed
+    // regionem równoległym trzeba ją odczytać do zmiennej - wątki OpenMP
+    // mają własne kopie thread_local.
+    static OpScope *&current()
+    {
+        static thread_local OpScope *op = nullptr;
+        return op;
+    }
+
+private:
+    const char *name_;
+    std::chrono::steady_clock::time_point start_;
+    std::vector<BusySlot> busy_;
+    OpScope *parent_;
+    int64_t edges_ = 0;
+    int64_t bytes_ = 0;
+    int64_t alloc_bytes_ = 0;
+};
+
+// Czas pracy wątku nad jedną częścią podziału, doliczany do operacji op.
+class BusyScope
+{
+public:
+    explicit BusyScope(OpScope *op) : op_(op)
+    {
+        if (op_)
+        {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~BusyScope()
+    {
+        if (op_)
+        {
+            op_->add_busy(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count());
+        }
+    }
+
+private:
+    OpScope *op_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+class OpScope
+{
+public:
+    explicit OpScope(const char *) {}
+    void work(int64_t, int64_t) {}
+    void alloc(int64_t) {}
+    static OpScope *current() { return nullptr; }
+};
+
+class BusyScope
+{
+public:
+    explicit BusyScope(OpScope *) {}
+};
+
+#endif
+
+// Szacowany ruch pamięci agregacji CSR x [N,H,D]: indptr, indices, wagi
+// data[E,H], odczyt wiersza sąsiada dla każdej krawędzi i zapis wyniku (fp32).
+inline int64_t spmm_bytes(int64_t rows, int64_t edges, int64_t H, int64_t D, int64_t value_bytes)
+{
+    return 8 * (rows + 1 + edges) + value_bytes * (edges * H + edges * H * D) + 4 * rows * H * D;
+}
+
+// Alokacja bufora pomocniczego w jądrze, doliczana do bieżącej operacji.
+inline void record_alloc(int64_t bytes)
+{
+    if (OpScope *op = OpScope::current())
+    {
+        op->alloc(bytes);
+    }
+}
+
+} // namespace spmm_stats
@@ -0,0 +1,346 @@
+#include "spmm_extension.h"
+#include <omp.h>
+
+// Alternatywne układy pamięci cech dla spmm_csr_3d:
+//
+// "nhd"   - [N,H,D]      domyślny, wszystkie heady węzła obok siebie
+// "hnd"   - [H,N,D]      head-major, każde przejście po grafie czyta jedną
+//                        płaszczyznę N*D (dobre przy dużym H, gdy [H,D] węzła
+//                        przestaje mieścić się w cache razem z sąsiadami)
+// "tiled" - [N/B,H,B,D]  kafle po B węzłów; w kaflu heady head-major, więc
+//                        wiersze B kolejnych węzłów dla jednego heada leżą
+//                        w jednym ciągłym bloku B*D
+//
+// to_layout/from_layout konwertują z/do [N,H,D], a spmm_csr_3d_layout liczy
+// agregację bezpośrednio w danym układzie (wynik w tym samym układzie).
+
+enum class LayoutKind
+{
+    NHD,
+    HND,
+    TILED
+};
+
+static LayoutKind parse_layout(const std::string &layout)
+{
+    if (layout == "nhd")
+        return LayoutKind::NHD;
+    if (layout == "hnd")
+        return LayoutKind::HND;
+    TORCH_CHECK(layout == "tiled", "unknown layout '", layout, "' (expected nhd, hnd or tiled)");
+    return LayoutKind::TILED;
+}
+
+static int64_t log2_exact(int64_t block)
+{
+    TORCH_CHECK(block > 0 && (block & (block - 1)) == 0, "tile block must be a power of two, got ", block);
+    int64_t log2_block = 0;
+    while ((int64_t(1) << log2_block) < block)
+    {
+        log2_block++;
+    }
+    return log2_block;
+}
+
+torch::Tensor to_layout(torch::Tensor x, const std::string &layout, int64_t block)
+{
+    TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+    int64_t N = x.size(0);
+    int64_t H = x.size(1);
+    int64_t D = x.size(2);
+
+    switch (parse_layout(layout))
+    {
+    case LayoutKind::NHD:
+        return x.contiguous();
+    case LayoutKind::HND:
+        return x.permute({1, 0, 2}).contiguous();
+    case LayoutKind::TILED:
+    {
+        log2_exact(block);
+        int64_t num_tiles = (N + block - 1) / block;
+        auto padded = x;
+        if (num_tiles * block != N)
+        {
+            padded = torch::cat({x, torch::zeros({num_tiles * block - N, H, D}, x.options())}, 0);
+        }
+        return padded.view({num_tiles, block, H, D}).permute({0, 2, 1, 3}).contiguous();
+    }
+    }
+    return x;
+}
+
+torch::Tensor from_layout(torch::Tensor x, const std::string &layout, int64_t num_nodes)
+{
+    switch (parse_layout(layout))
+    {
+    case LayoutKind::NHD:
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+        return x.contiguous();
+    case LayoutKind::HND:
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [H,N,D]");
+        return x.permute({1, 0, 2}).contiguous();
+    case LayoutKind::TILED:
+    {
+        TORCH_CHECK(x.dim() == 4, "x must be 4D [N/B,H,B,D]");
+        int64_t num_tiles = x.size(0);
+        int64_t H = x.size(1);
+        int64_t block = x.size(2);
+        int64_t D = x.size(3);
+        TORCH_CHECK(num_nodes <= num_tiles * block, "num_nodes exceeds tiled capacity");
+        return x.permute({0, 2, 1, 3}).reshape({num_tiles * block, H, D}).narrow(0, 0, num_nodes).contiguous();
+    }
+    }
+    return x;
+}
+
+// Wywołuje fn(layout, H, D, num_nodes) z obiektem układu odpowiadającym tensorowi x.
+template <typename Fn>
+static void with_layout(LayoutKind kind, const torch::Tensor &x, Fn &&fn)
+{
+    switch (kind)
+    {
+    case LayoutKind::NHD:
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+        fn(NodeMajorLayout{x.size(1), x.size(2)}, x.size(1), x.size(2), x.size(0));
+        break;
+    case LayoutKind::HND:
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [H,N,D]");
+        fn(HeadMajorLayout{x.size(1), x.size(2)}, x.size(0), x.size(2), x.size(1));
+        break;
+    case LayoutKind::TILED:
+        TORCH_CHECK(x.dim() == 4, "x must be 4D [N/B,H,B,D]");
+        fn(TiledLayout{x.size(1), x.size(3), log2_exact(x.size(2))}, x.size(1), x.size(3), x.size(0) * x.size(2));
+        break;
+    }
+}
+
+// Pusty tensor wyniku dla num_rows węzłów w układzie jak x.
+static torch::Tensor empty_like_layout(LayoutKind kind, const torch::Tensor &x, int64_t num_rows)
+{
+    switch (kind)
+    {
+    case LayoutKind::NHD:
+        return torch::empty({num_rows, x.size(1), x.size(2)}, x.options());
+    case LayoutKind::HND:
+        return torch::empty({x.size(0), num_rows, x.size(2)}, x.options());
+    case LayoutKind::TILED:
+    {
+        // wiersze dopełnienia ostatniego kafla nie są pisane przez jądro
+        int64_t block = x.size(2);
+        return torch::zeros({(num_rows + block - 1) / block, x.size(1), block, x.size(3)}, x.options());
+    }
+    }
+    return torch::Tensor();
+}
+
+static int64_t default_head_block(LayoutKind kind, int64_t H, int64_t head_block)
+{
+    if (head_block > 0)
+    {
+        return head_block;
+    }
+    return kind == LayoutKind::NHD ? H : 1;
+}
+
+// result (układ x, num_rows wierszy) = A[CSR] * x
+static torch::Tensor spmm_layout_forward(
+    LayoutKind kind,
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor x,
+    const CsrPartition &part,
+    int64_t head_block)
+{
+    int64_t num_rows = indptr.size(0) - 1;
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_layout_forward", indices, indptr, data, x);
+    auto result = empty_like_layout(kind, x, num_rows);
+    auto result_ptr = result.data_ptr<float>();
+    op.alloc(result.nbytes());
+
+    with_layout(kind, x, [&](auto x_layout, int64_t H, int64_t D, int64_t)
+    {
+        TORCH_CHECK(data.size(1) == H, "data second dim must match H");
+        op.work(indices.size(0), spmm_stats::spmm_bytes(num_rows, indices.size(0), H, D, 4));
+        using Layout = decltype(x_layout);
+        SpmmInput<Layout> in{indices.data_ptr<int64_t>(), data.data_ptr<float>(), x.data_ptr<float>(), x_layout, H, D};
+
+        with_layout(kind, result, [&](auto out_layout, int64_t, int64_t, int64_t)
+        {
+            spmm_csr_3d_partitioned(part, indptr.data_ptr<int64_t>(), in, result_ptr, out_layout,
+                                    default_head_block(kind, H, head_block));
+        });
+    });
+
+    return result;
+}
+
+class SpmmCsr3dLayoutFunction : public torch::autograd::Function<SpmmCsr3dLayoutFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor data,
+        torch::Tensor x,
+        std::string layout,
+        std::shared_ptr<CsrPartition> partition,
+        int64_t head_block,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(data.dim() == 2, "data must be 2D [E,H]");
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        data = data.contiguous();
+        x = x.contiguous();
+
+        LayoutKind kind = parse_layout(layout);
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+        TORCH_CHECK(part.num_rows == indptr.size(0) - 1 && part.nnz == indices.size(0),
+                    "partition was built for a different graph");
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        if (graph)
+        {
+            t_indptr = graph->t_indptr;
+            t_rows = graph->t_rows;
+            t_perm = graph->t_perm;
+            ctx->saved_data["row_start_t"] = graph->partition_t.row_start;
+            ctx->saved_data["edge_start_t"] = graph->partition_t.edge_start;
+        }
+
+        ctx->save_for_backward({indices, indptr, data, x, t_indptr, t_rows, t_perm});
+        ctx->saved_data["layout"] = layout;
+        ctx->saved_data["head_block"] = head_block;
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+        return spmm_layout_forward(kind, indices, indptr, data, x, part, head_block);
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto data = saved[2];
+        auto x = saved[3];
+        auto grad_out = grad_outputs[0].contiguous();
+        LayoutKind kind = parse_layout(ctx->saved_data["layout"].toStringRef());
+        int64_t head_block = ctx->saved_data["head_block"].toInt();
+
+        CsrPartition part;
+        part.num_rows = indptr.size(0) - 1;
+        part.nnz = indices.size(0);
+        part.row_start = ctx->saved_data["row_start"].toIntVector();
+        part.edge_start = ctx->saved_data["edge_start"].toIntVector();
+
+        torch::Tensor grad_data, grad_x;
+
+        if (ctx->needs_input_grad(2))
+        {
+            // grad_data[e,h] = <grad_out[row(e),h,:], x[col(e),h,:]>
+            SPMM_OP_SCOPE(op, "spmm_csr_3d_layout_backward_data", indices, indptr, grad_out, x);
+            grad_data = torch::empty_like(data);
+            op.alloc(grad_data.nbytes());
+            spmm_stats::OpScope *busy_op = spmm_stats::OpScope::current();
+            auto indices_ptr = indices.data_ptr<int64_t>();
+            auto indptr_ptr = indptr.data_ptr<int64_t>();
+            auto g_ptr = grad_out.data_ptr<float>();
+            auto x_ptr = x.data_ptr<float>();
+            auto grad_data_ptr = grad_data.data_ptr<float>();
+
+            with_layout(kind, x, [&](auto x_layout, int64_t H, int64_t D, int64_t)
+            {
+                op.work(indices.size(0), 8 * (indptr.size(0) + indices.size(0)) + 4 * (2 * indices.size(0) * H * D + indices.size(0) * H));
+                with_layout(kind, grad_out, [&](auto g_layout, int64_t, int64_t, int64_t)
+                {
+#pragma omp parallel for schedule(static, 1)
+                    for (int64_t p = 0; p < part.num_parts(); p++)
+                    {
+                        spmm_stats::BusyScope busy(busy_op);
+                        part.for_each_segment(p, indptr_ptr, [&](int64_t, int64_t row, int64_t begin, int64_t end, bool)
+                        {
+                            for (int64_t i = begin; i < end; i++)
+                            {
+                                for (int64_t h = 0; h < H; h++)
+                                {
+                                    const float *g_row = g_ptr + g_layout.offset(row) + h * g_layout.head_stride();
+                                    const float *in_row = x_ptr + x_layout.offset(indices_ptr[i]) + h * x_layout.head_stride();
+                                    float acc = 0.0f;
+                                    for (int64_t d = 0; d < D; d++)
+                                    {
+                                        acc += g_row[d] * in_row[d];
+                                    }
+                                    grad_data_ptr[i * H + h] = acc;
+                                }
+                            }
+                        });
+                    }
+                });
+            });
+        }
+
+        if (ctx->needs_input_grad(3))
+        {
+            // grad_x = A^T * grad_out - to samo jądro po CSC, wynik w układzie x
+            auto t_indptr = saved[4];
+            auto t_rows = saved[5];
+            auto t_perm = saved[6];
+            CsrPartition part_t;
+            if (t_indptr.defined())
+            {
+                part_t.num_rows = t_indptr.size(0) - 1;
+                part_t.nnz = indices.size(0);
+                part_t.row_start = ctx->saved_data["row_start_t"].toIntVector();
+                part_t.edge_start = ctx->saved_data["edge_start_t"].toIntVector();
+            }
+            else
+            {
+                int64_t num_nodes = 0;
+                with_layout(kind, x, [&](auto, int64_t, int64_t, int64_t n) { num_nodes = n; });
+
+                auto t = csr_transpose(indices, indptr, num_nodes);
+                t_indptr = t[0];
+                t_rows = t[1];
+                t_perm = t[2];
+                part_t = make_partition(t_indptr, 0);
+            }
+
+            auto data_t = data.index_select(0, t_perm).contiguous();
+            grad_x = spmm_layout_forward(kind, t_rows, t_indptr, data_t, grad_out, part_t, head_block);
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_data, grad_x, torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    }
+};
+
+torch::Tensor spmm_csr_3d_layout(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor x,
+    const std::string &layout,
+    std::shared_ptr<CsrPartition> partition,
+    int64_t head_block)
+{
+    return SpmmCsr3dLayoutFunction::apply(indices, indptr, data, x, layout, partition, head_block, std::shared_ptr<CSRGraph>());
+}
+
+torch::Tensor spmm_csr_3d_layout_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    torch::Tensor x,
+    const std::string &layout,
+    int64_t head_block)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SpmmCsr3dLayoutFunction::apply(graph->indices, graph->indptr, data, x, layout, partition, head_block, graph);
+}
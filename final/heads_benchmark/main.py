@@ -1,3 +1,4 @@
+import argparse
 import torch
 import time
 import random
@@ -5,6 +6,7 @@ import numpy as np
 from torch_geometric.datasets import Planetoid
 from torch_sparse import SparseTensor
 from my_gat_layer import MyGATLayer
+import spmm_extension
 
 def seed_everything(seed=42):
     random.seed(seed)
@@ -14,15 +16,82 @@ def seed_everything(seed=42):
     torch.backends.cudnn.deterministic = True
     torch.backends.cudnn.benchmark = False
 
+# Przybliżony rozmiar L2 na rdzeń - do automatycznego wyboru układu
+L2_BYTES = 1 << 20
+
+def gathered_rows(rowptr, col, threads):
+    # Liczba różnych wierszy źródłowych czytanych przez jeden wątek: wiersze
+    # docelowe dzielone są na `threads` ciągłych części, a sąsiedzi z różnych
+    # wierszy części powtarzają się dopiero po przejściu wielu wierszy - żeby
+    # ponowny odczyt trafił w cache, w L2 musi zmieścić się cały ten zbiór.
+    num_rows = rowptr.numel() - 1
+    bounds = torch.linspace(0, num_rows, threads + 1).long()
+    distinct = 0
+    for t in range(threads):
+        begin, end = rowptr[bounds[t]].item(), rowptr[bounds[t + 1]].item()
+        distinct = max(distinct, col[begin:end].unique().numel())
+    return distinct
+
+def choose_layout(heads, out_channels, distinct_rows):
+    # W [N,H,D] wątek zbiera pełne wiersze [H,D] sąsiadów: zbiór roboczy to
+    # distinct_rows * H * D * 4 B. W [H,N,D] (heady na zewnątrz) w danej chwili
+    # potrzebny jest tylko wycinek jednego heada: distinct_rows * D * 4 B.
+    # hnd wybieramy, gdy pierwszy zbiór nie mieści się w L2, a drugi tak.
+    nhd_bytes = distinct_rows * heads * out_channels * 4
+    hnd_bytes = distinct_rows * out_channels * 4
+    return 'hnd' if nhd_bytes > L2_BYTES and hnd_bytes <= L2_BYTES else 'nhd'
+
+def check_gat_project(num_nodes=200, in_channels=50, heads=4, out_channels=8, atol=1e-4):
+    # Porównanie gat_project (forward i backward GatProjectFunction) z tym samym
+    # wyrażeniem liczonym przez autograd PyTorch, dla losowych gradientów wyjść.
+    # gat_project jest tylko fp32, więc zamiast gradcheck (fp64) porównujemy
+    # gradienty z referencją.
+    x = torch.randn(num_nodes, in_channels, requires_grad=True)
+    W = torch.randn(in_channels, heads * out_channels, requires_grad=True)
+    a_src = torch.randn(heads, out_channels, requires_grad=True)
+    a_dst = torch.randn(heads, out_channels, requires_grad=True)
+    inputs = [x, W, a_src, a_dst]
+
+    x_proj_ref = (x @ W).view(num_nodes, heads, out_channels)
+    ref = [x_proj_ref, (x_proj_ref * a_src).sum(dim=2), (x_proj_ref * a_dst).sum(dim=2)]
+    out = spmm_extension.gat_project(x, W, a_src, a_dst)
+
+    grads_out = [torch.randn_like(r) for r in ref]
+    grads_ref = torch.autograd.grad(ref, inputs, grads_out)
+    grads = torch.autograd.grad(out, inputs, grads_out)
+
+    ok = all(torch.allclose(o, r, atol=atol) for o, r in zip(out, ref))
+    ok = ok and all(torch.allclose(g, r, atol=atol, rtol=1e-4) for g, r in zip(grads, grads_ref))
+    print("Czy gat_project (forward i backward) zgadza się z autograd?", ok)
+    if not ok:
+        for name, g, r in zip(['x', 'W', 'a_src', 'a_dst'], grads, grads_ref):
+            print(f"  maksymalna różnica grad_{name}:", (g - r).abs().max().item())
+    return ok
+
 class SimpleGATModel(torch.nn.Module):
-    def __init__(self, in_channels, out_channels, heads=1):
+    def __init__(self, in_channels, out_channels, heads=1, layout='nhd', tile_block=16, storage_dtype=None):
         super(SimpleGATModel, self).__init__()
-        self.gat = MyGATLayer(in_channels, out_channels, heads=heads, dropout=0.0)
+        self.gat = MyGATLayer(in_channels, out_channels, heads=heads, dropout=0.0,
+                              layout=layout, tile_block=tile_block, storage_dtype=storage_dtype)
 
     def forward(self, x, edge_index_or_sparse):
         return self.gat(x, edge_index_or_sparse)
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--layout', choices=['nhd', 'hnd', 'tiled', 'auto'], default='nhd',
+                        help="układ x_proj dla ścieżki CSR ('auto' - wybór wg zbioru roboczego sąsiadów i L2)")
+    parser.add_argument('--tile-block', type=int, default=16, help="B dla układu 'tiled'")
+    parser.add_argument('--storage', choices=['fp32', 'fp16', 'bf16'], default='fp32',
+                        help="typ att i x_proj czytanych przez spmm_csr_3d (akumulacja zawsze fp32)")
+    parser.add_argument('--reorder', choices=['none', 'rcm', 'degree', 'community'], default='none',
+                        help="przenumerowanie wierzchołków dla dodatkowego przebiegu na CSRGraph")
+    args = parser.parse_args()
+
+    storage_dtype = {'fp32': None, 'fp16': torch.float16, 'bf16': torch.bfloat16}[args.storage]
+    # przy 16-bitowym przechowywaniu wyniki CSR porównujemy z COO z tolerancją
+    atol = 1e-6 if storage_dtype is None else 1e-2
+
    #seed_everything(42)
     dataset = Planetoid(root='data/Planetoid', name='Cora')
     data = dataset[0]
@@ -42,9 +111,34 @@ if __name__ == "__main__":
     x = data.x
     y = data.y
 
+    # Przenumerowany CSRGraph (wiersze - węzły docelowe, indices - źródła).
+    # Graf i cechy są przenumerowywane raz, wynik wraca przez unpermute_nodes.
+    reordered = None
+    if args.reorder != 'none':
+        indptr, indices = spmm_extension.coo_to_csr(edge_index[1], edge_index[0], None, num_nodes)[:2]
+        start = time.time()
+        reordered = spmm_extension.reorder_graph(indptr, indices, args.reorder)
+        x_reordered = spmm_extension.permute_nodes(reordered, x)
+        end = time.time()
+        print(f"Przenumerowanie ({args.reorder}) zajęło:", (end - start)*1000, "ms")
+        print("Lokalność przed:", spmm_extension.locality_report(indptr, indices))
+        print("Lokalność po:   ", spmm_extension.locality_report(reordered.indptr, reordered.indices))
+
+    check_gat_project()
+
+    if args.layout == 'auto':
+        rowptr, col, _ = edge_index_csr.csr()
+        distinct_rows = gathered_rows(rowptr, col, torch.get_num_threads())
+        print("Różne wiersze źródłowe na wątek:", distinct_rows)
+
     for heads in [1, 2, 4, 8, 16, 32, 64, 128, 256, 512 ]:
         print(f"Testowanie dla heads = {heads}")
-        model = SimpleGATModel(in_channels=x.size(1), out_channels=8, heads=heads)
+        layout = args.layout
+        if layout == 'auto':
+            layout = choose_layout(heads, 8, distinct_rows)
+        print(f"Układ pamięci CSR: {layout}")
+        model = SimpleGATModel(in_channels=x.size(1), out_channels=8, heads=heads,
+                               layout=layout, tile_block=args.tile_block, storage_dtype=storage_dtype)
         model.train()
 
         # Propagacja z COO
@@ -59,10 +153,44 @@ if __name__ == "__main__":
         end = time.time()
         print(f"Propagacja CSR z heads={heads} zajęła:", (end - start)*1000, "ms")
 
+        # Propagacja z CSR (jądro złączone)
+        model.gat.fused = True
+        start = time.time()
+        out_fused = model(x, edge_index_csr)
+        end = time.time()
+        model.gat.fused = False
+        print(f"Propagacja CSR (fused) z heads={heads} zajęła:", (end - start)*1000, "ms")
+
+        # Propagacja z przenumerowanego CSRGraph
+        if reordered is not None:
+            start = time.time()
+            out_reordered = spmm_extension.unpermute_nodes(reordered, model(x_reordered, reordered))
+            end = time.time()
+            print(f"Propagacja CSR ({args.reorder}) z heads={heads} zajęła:", (end - start)*1000, "ms")
+
         # Porównanie wyników
-        are_close = torch.allclose(out_coo, out_csr, atol=1e-6)
+        are_close = torch.allclose(out_coo, out_csr, atol=atol)
         print(f"Czy wyniki COO i CSR są identyczne (heads={heads})?", are_close)
         if not are_close:
             diff = (out_coo - out_csr).abs().max()
             print(f"Maksymalna różnica (heads={heads}):", diff.item())
 
+        are_close = torch.allclose(out_coo, out_fused, atol=atol)
+        print(f"Czy wyniki COO i CSR (fused) są identyczne (heads={heads})?", are_close)
+        if not are_close:
+            diff = (out_coo - out_fused).abs().max()
+            print(f"Maksymalna różnica fused (heads={heads}):", diff.item())
+
+        if reordered is not None:
+            are_close = torch.allclose(out_coo, out_reordered, atol=atol)
+            print(f"Czy wyniki COO i CSR ({args.reorder}) są identyczne (heads={heads})?", are_close)
+            if not are_close:
+                diff = (out_coo - out_reordered).abs().max()
+                print(f"Maksymalna różnica {args.reorder} (heads={heads}):", diff.item())
+
+        # Liczniki operacji rozszerzenia (tylko przy budowie z SPMM_STATS=1)
+        if spmm_extension.STATS_ENABLED:
+            for name, op in spmm_extension.stats(reset=True).items():
+                print(f"  {name}: {op['calls']} wywołań, {op['time_ms']:.3f} ms, "
+                      f"{op['bytes'] / max(op['time_ms'], 1e-9) / 1e6:.2f} GB/s, "
+                      f"alokacje {op['alloc_bytes'] / 2**20:.1f} MiB, nierównowaga wątków {op['imbalance']:.2f}")
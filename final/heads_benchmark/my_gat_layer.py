@@ -1,3 +1,4 @@
+import weakref
 import torch
 import torch.nn.functional as F
 from torch_scatter import scatter_add, scatter_max
@@ -33,12 +34,54 @@ def segment_softmax(e, segment_ids, num_segments=None):
     return att
 
 class MyGATLayer(torch.nn.Module):
-    def __init__(self, in_channels, out_channels, heads=8, dropout=0.6):
+    def __init__(self, in_channels, out_channels, heads=8, dropout=0.6, negative_slope=0.2, fused=False,
+                 layout='nhd', tile_block=16, storage_dtype=None, int8_inference=False):
         super(MyGATLayer, self).__init__()
         self.in_channels = in_channels
         self.out_channels = out_channels
         self.heads = heads
         self.dropout = dropout
+        self.negative_slope = negative_slope
+        # fused=True: dla SparseTensor cała uwaga (LeakyReLU, softmax, agregacja)
+        # liczona jest jednym wywołaniem spmm_extension.gat_fused_csr
+        self.fused = fused
+        # układ pamięci x_proj dla ścieżki CSR: 'nhd' [N,H,D], 'hnd' [H,N,D]
+        # albo 'tiled' [N/B,H,B,D] (B = tile_block), patrz layouts.cpp
+        self.layout = layout
+        self.tile_block = tile_block
+        # storage_dtype=torch.bfloat16/torch.float16: att i x_proj są podawane
+        # do spmm_csr_3d w 16 bitach (połowa bajtów na sąsiada), akumulacja
+        # i wynik pozostają w fp32 (tylko układ 'nhd')
+        self.storage_dtype = storage_dtype
+        # int8_inference=True: poza treningiem (bez gradientu) x_proj jest
+        # kwantyzowany do int8 na wiersz i head, a agregacja czyta 1 bajt na
+        # cechę sąsiada (spmm_csr_3d_int8, tylko układ 'nhd')
+        self.int8_inference = int8_inference
+
+        # kwantyzacja jest liczona raz dla tych samych obiektów x i W
+        # (weakref, porównanie przez `is` - nowy tensor może dostać adres
+        # zwolnionego) i tylko dopóki nie zmieniono ich w miejscu (_version)
+        self._x_q = None
+        self._x_q_refs = None
+        self._x_q_versions = None
+
+        # graf jest statyczny przez cały przebieg, więc CSRGraph (CSR, CSC,
+        # podział merge-path) i krawędzie posortowane po col budowane są raz
+        # dla danego SparseTensor i używane ponownie w kolejnych forward.
+        # SparseTensor rozpoznawany jest po tożsamości (weakref), a nie po
+        # adresie col - bufor zwolnionego minibatcha bywa użyty ponownie
+        self._graph = None
+        self._graph_edges = None
+        self._graph_ref = None
+        self._graph_key = None
+
+        # permutacja sortująca krawędzie po col (coo_to_csr) - też zależy
+        # tylko od grafu, więc nie jest liczona od nowa w każdym forward.
+        # Klucz to tożsamość źródła krawędzi (edge_index albo SparseTensor,
+        # przez weakref) i _version dla edge_index zmienianego w miejscu
+        self._col_perm = None
+        self._col_perm_ref = None
+        self._col_perm_key = None
 
         self.W = torch.nn.Parameter(torch.Tensor(in_channels, heads * out_channels))
         self.a_src = torch.nn.Parameter(torch.Tensor(heads, out_channels))
@@ -48,25 +91,83 @@ class MyGATLayer(torch.nn.Module):
         torch.nn.init.xavier_uniform_(self.a_src)
         torch.nn.init.xavier_uniform_(self.a_dst)
 
+    def _get_graph(self, sparse_t, num_nodes):
+        key = (num_nodes, self.fused)
+        if self._graph_ref is None or self._graph_ref() is not sparse_t or self._graph_key != key:
+            if self.fused:
+                # Wiersze CSC (colptr, row) to węzły docelowe, a indices to ich źródła
+                colptr, row, _ = sparse_t.csc()
+                self._graph = spmm_extension.CSRGraph(colptr, row)
+                self._graph_edges = None
+            else:
+                row, col, _ = sparse_t.coo()
+                idx = self._get_col_perm(sparse_t, row, col, num_nodes)
+                row = row[idx]
+                col = col[idx]
+                # Zamiast ręcznego tworzenia indptr, używamy istniejącego CSR
+                indptr = sparse_t.csr()[0]
+                self._graph = spmm_extension.CSRGraph(indptr, row)
+                self._graph_edges = (row, col)
+            self._graph_ref = weakref.ref(sparse_t)
+            self._graph_key = key
+        return self._graph, self._graph_edges
+
+    def _get_col_perm(self, source, row, col, num_nodes):
+        key = (getattr(source, '_version', None), num_nodes)
+        if self._col_perm_ref is None or self._col_perm_ref() is not source or self._col_perm_key != key:
+            # CSR po col: krawędzie posortowane po (col, row)
+            self._col_perm = spmm_extension.coo_to_csr(col, row, None, num_nodes)[3]
+            self._col_perm_ref = weakref.ref(source)
+            self._col_perm_key = key
+        return self._col_perm
+
+    def _get_quantized(self, x, x_proj):
+        versions = (x._version, self.W._version)
+        if (self._x_q_refs is None or self._x_q_refs[0]() is not x or self._x_q_refs[1]() is not self.W
+                or self._x_q_versions != versions):
+            self._x_q = spmm_extension.QuantizedFeatures(x_proj, per_head=True)
+            self._x_q_refs = (weakref.ref(x), weakref.ref(self.W))
+            self._x_q_versions = versions
+        return self._x_q
+
+    def _aggregate(self, graph, att, x, x_proj, N):
+        if self.layout == 'nhd':
+            if self.int8_inference and not torch.is_grad_enabled():
+                x_q = self._get_quantized(x, x_proj)
+                return spmm_extension.spmm_csr_3d_int8(graph, att, x_q).to(x_proj.dtype)  # [N,H,D]
+            if self.storage_dtype is not None:
+                return spmm_extension.spmm_csr_3d(graph, att.to(self.storage_dtype), x_proj.to(self.storage_dtype),
+                                                  out_dtype=x_proj.dtype)  # [N,H,D]
+            return spmm_extension.spmm_csr_3d(graph, att, x_proj)  # [N,H,D]
+        x_l = spmm_extension.to_layout(x_proj, self.layout, self.tile_block)
+        out_l = spmm_extension.spmm_csr_3d_layout(graph, att, x_l, self.layout)
+        return spmm_extension.from_layout(out_l, self.layout, N)  # [N,H,D]
+
     def forward(self, x, edge_index_or_sparse):
         N = x.size(0)
 
-        x_proj = x @ self.W  # [N, H*D]
-        x_proj = x_proj.view(N, self.heads, self.out_channels)  # [N,H,D]
+        if x.dtype == torch.float32:
+            # x @ W w BLAS, oba współczynniki uwagi w jednym przejściu po x_proj (gat_project.cpp),
+            # bez tymczasowych [N,H,D] na (x_proj * a)
+            x_proj, alpha_src, alpha_dst = spmm_extension.gat_project(x, self.W, self.a_src, self.a_dst)
+        else:
+            x_proj = x @ self.W  # [N, H*D]
+            x_proj = x_proj.view(N, self.heads, self.out_channels)  # [N,H,D]
 
-        Q = x_proj
-        K = x_proj
+            Q = x_proj
+            K = x_proj
 
-        alpha_src = (Q * self.a_src).sum(dim=2)  # [N,H]
-        alpha_dst = (K * self.a_dst).sum(dim=2)  # [N,H]
+            alpha_src = (Q * self.a_src).sum(dim=2)  # [N,H]
+            alpha_dst = (K * self.a_dst).sum(dim=2)  # [N,H]
 
         if isinstance(edge_index_or_sparse, torch.Tensor):
             # COO
             edge_index = edge_index_or_sparse
             row, col = edge_index
             e = alpha_src[row] + alpha_dst[col]  # [E,H]
+            e = F.leaky_relu(e, self.negative_slope)
 
-            idx = torch.argsort(col)
+            idx = self._get_col_perm(edge_index, row, col, N)
             row = row[idx]
             col = col[idx]
             e = e[idx]
@@ -79,28 +180,36 @@ class MyGATLayer(torch.nn.Module):
             out_sum = torch.zeros(N, self.heads, self.out_channels, device=x.device, dtype=x.dtype)
             out_sum = scatter_add(out_feat, col, dim=0, out=out_sum)
 
+        elif isinstance(edge_index_or_sparse, spmm_extension.CSRGraph):
+            # gotowy CSRGraph: wiersze to węzły docelowe, indices to ich źródła
+            graph = edge_index_or_sparse
+            if self.fused:
+                out_sum = spmm_extension.gat_fused_csr(
+                    graph, alpha_src, alpha_dst, x_proj, self.negative_slope)  # [N,H,D]
+            else:
+                dst = torch.repeat_interleave(torch.arange(N, device=x.device), graph.out_degree)
+                e = alpha_src[graph.indices] + alpha_dst[dst]  # [E,H]
+                e = F.leaky_relu(e, self.negative_slope)
+                att = segment_softmax(e, dst, num_segments=N)  # [E,H]
+                out_sum = self._aggregate(graph, att, x, x_proj, N)
+
+        elif self.fused:
+            # CSR (SparseTensor), wersja złączona
+            graph, _ = self._get_graph(edge_index_or_sparse, N)
+            out_sum = spmm_extension.gat_fused_csr(
+                graph, alpha_src, alpha_dst, x_proj, self.negative_slope)  # [N,H,D]
+
         else:
             # CSR (SparseTensor)
-            sparse_t = edge_index_or_sparse
-            row, col, _ = sparse_t.coo()
-
-            idx = torch.argsort(col)
-            row = row[idx]
-            col = col[idx]
+            graph, (row, col) = self._get_graph(edge_index_or_sparse, N)
 
             e = alpha_src[row] + alpha_dst[col]  # [E,H]
+            e = F.leaky_relu(e, self.negative_slope)
             att = segment_softmax(e, col, num_segments=N)  # [E,H]
 
-            # Zamiast ręcznego tworzenia indptr, używamy istniejącego CSR
-            indptr = sparse_t.csr()[0]  # Uzyskujemy indptr z macierzy SparseTensor
-
-            # Teraz bez spłaszczania:
-            #print(sparse_t.csr())
-        
-            # att: [E,H], x_proj: [N,H,D] 
+            # att: [E,H], x_proj: [N,H,D]
             # Chcemy: out_sum: [N,H,D]
-
-            out_sum = spmm_extension.spmm_csr_3d(row, indptr, att, x_proj)  # [N,H,D]
+            out_sum = self._aggregate(graph, att, x, x_proj, N)
 
         out = out_sum.view(N, self.heads * self.out_channels)
         out = F.dropout(out, p=self.dropout, training=self.training)
@@ -0,0 +1,106 @@
+#include "spmm_extension.h"
+#include "quantized.h"
+
+// Skwantowane cechy węzłów (quantized.h) i agregacja CSR x int8 do
+// zastosowań tylko-inferencyjnych: q zajmuje 1/4 pamięci fp32, a jądro
+// czyta 1 bajt na cechę sąsiada. spmm_csr_3d_int8 nie ma backward.
+
+std::shared_ptr<QuantizedFeatures> QuantizedFeatures::build(torch::Tensor x, bool per_head)
+{
+    TORCH_CHECK(x.dim() == 2 || x.dim() == 3, "x must be 2D [N,F] or 3D [N,H,D]");
+    TORCH_CHECK(at::isFloatingType(x.scalar_type()), "x must be a floating point tensor");
+
+    auto qf = std::make_shared<QuantizedFeatures>();
+    auto x_f = x.detach().to(torch::kFloat32).contiguous();
+    qf->num_nodes = x.size(0);
+    qf->H = x.dim() == 3 ? x.size(1) : 1;
+    qf->D = x.dim() == 3 ? x.size(2) : x.size(1);
+    qf->per_head = per_head;
+
+    int64_t G = per_head ? qf->num_nodes * qf->H : qf->num_nodes;
+    int64_t L = per_head ? qf->D : qf->H * qf->D;
+
+    qf->q = torch::empty(x.sizes(), x_f.options().dtype(torch::kInt8));
+    qf->scale = torch::empty({G}, x_f.options());
+    qf->zero_point = torch::empty({G}, x_f.options().dtype(torch::kInt32));
+    quantize_groups(x_f.data_ptr<float>(), G, L,
+                    qf->q.data_ptr<int8_t>(), qf->scale.data_ptr<float>(), qf->zero_point.data_ptr<int32_t>());
+
+    if (per_head)
+    {
+        qf->scale = qf->scale.view({qf->num_nodes, qf->H});
+        qf->zero_point = qf->zero_point.view({qf->num_nodes, qf->H});
+    }
+    return qf;
+}
+
+torch::Tensor QuantizedFeatures::dequantize() const
+{
+    int64_t G = scale.numel();
+    auto x = torch::empty(q.sizes(), scale.options());
+    dequantize_groups(q.data_ptr<int8_t>(), scale.data_ptr<float>(), zero_point.data_ptr<int32_t>(),
+                      G, q.numel() / std::max<int64_t>(G, 1), x.data_ptr<float>());
+    return x;
+}
+
+int64_t QuantizedFeatures::nbytes() const
+{
+    return q.numel() * 1 + scale.numel() * 4 + zero_point.numel() * 4;
+}
+
+// Funkcja: spmm_csr_3d_int8
+// Jak spmm_csr_3d, ale cechy są skwantowane (QuantizedFeatures [N,H,D])
+// i dekwantowane w pętli gather. data [E,H] w fp32, wynik [N,H,D] w fp32.
+torch::Tensor spmm_csr_3d_int8(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    std::shared_ptr<QuantizedFeatures> features,
+    std::shared_ptr<CsrPartition> partition)
+{
+    TORCH_CHECK(features, "features must not be None");
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+    TORCH_CHECK(data.dim() == 2, "data must be 2D [E,H]");
+    TORCH_CHECK(features->q.dim() == 3, "features must be quantized from a 3D [N,H,D] tensor");
+
+    indices = indices.contiguous();
+    indptr = indptr.contiguous();
+    data = data.detach().to(torch::kFloat32).contiguous();
+
+    int64_t num_rows = indptr.size(0) - 1;
+    int64_t H = features->H;
+    int64_t D = features->D;
+    TORCH_CHECK(data.size(0) == indices.size(0) && data.size(1) == H, "data must be [E,H] with H matching features");
+
+    CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+    TORCH_CHECK(part.num_rows == num_rows && part.nnz == indices.size(0),
+                "partition was built for a different graph");
+
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_int8", indices, indptr, data);
+    // odczyt sąsiada: D bajtów cech + skala i punkt zera
+    op.work(indices.size(0), spmm_stats::spmm_bytes(num_rows, indices.size(0), H, 0, 4) + indices.size(0) * H * (D + 8) + 4 * num_rows * H * D);
+
+    auto result = torch::empty({num_rows, H, D}, data.options());
+    op.alloc(result.nbytes());
+    QuantizedSpmmInput in{
+        indices.data_ptr<int64_t>(),
+        data.data_ptr<float>(),
+        features->q.data_ptr<int8_t>(),
+        features->scale.data_ptr<float>(),
+        features->zero_point.data_ptr<int32_t>(),
+        H, D, features->per_head};
+    spmm_csr_3d_int8_partitioned(part, indptr.data_ptr<int64_t>(), in, result.data_ptr<float>());
+    return result;
+}
+
+torch::Tensor spmm_csr_3d_int8_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    std::shared_ptr<QuantizedFeatures> features)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(features && features->num_nodes == graph->num_cols, "features must have num_cols rows");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return spmm_csr_3d_int8(graph->indices, graph->indptr, data, features, partition);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "spmm_kernels.h"
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Cechy węzłów [N,H,D] skwantowane do int8 z osobną skalą i punktem zera
+// dla każdej grupy: wiersza (grupa = węzeł, H*D wartości) albo wiersza
+// i heada (grupa = (węzeł, h), D wartości):
+//   x ≈ scale[g] * (q - zero_point[g])
+// Kwantyzacja asymetryczna: zakres [min, max] grupy mapowany na [-128, 127].
+
+// Funkcja: quantize_groups
+// x [G, L] (G grup po L wartości) -> q [G, L], scale [G], zero_point [G].
+inline void quantize_groups(
+    const float *x,
+    int64_t G,
+    int64_t L,
+    int8_t *q,
+    float *scale,
+    int32_t *zero_point)
+{
+#pragma omp parallel for schedule(static)
+    for (int64_t g = 0; g < G; g++)
+    {
+        const float *row = x + g * L;
+        float lo = L > 0 ? row[0] : 0.0f;
+        float hi = lo;
+        for (int64_t i = 1; i < L; i++)
+        {
+            lo = std::min(lo, row[i]);
+            hi = std::max(hi, row[i]);
+        }
+
+        float s;
+        int32_t zp;
+        if (hi > lo)
+        {
+            s = (hi - lo) / 255.0f;
+            zp = static_cast<int32_t>(std::lround(-128.0f - lo / s));
+        }
+        else
+        {
+            // stała grupa: dokładnie odtwarzana jako q = ±127 (albo 0)
+            s = lo != 0.0f ? std::fabs(lo) / 127.0f : 1.0f;
+            zp = 0;
+        }
+        scale[g] = s;
+        zero_point[g] = zp;
+
+        float inv = 1.0f / s;
+        int8_t *q_row = q + g * L;
+        for (int64_t i = 0; i < L; i++)
+        {
+            long v = std::lround(row[i] * inv) + zp;
+            q_row[i] = static_cast<int8_t>(std::min<long>(127, std::max<long>(-128, v)));
+        }
+    }
+}
+
+// Funkcja: dequantize_groups
+// q [G, L] -> x [G, L] = scale[g] * (q - zero_point[g])
+inline void dequantize_groups(
+    const int8_t *q,
+    const float *scale,
+    const int32_t *zero_point,
+    int64_t G,
+    int64_t L,
+    float *x)
+{
+#pragma omp parallel for schedule(static)
+    for (int64_t g = 0; g < G; g++)
+    {
+        float s = scale[g];
+        float zp = static_cast<float>(zero_point[g]);
+        const int8_t *q_row = q + g * L;
+        float *x_row = x + g * L;
+#pragma omp simd
+        for (int64_t i = 0; i < L; i++)
+        {
+            x_row[i] = s * (static_cast<float>(q_row[i]) - zp);
+        }
+    }
+}
+
+// Wejście jądra int8: wzorzec CSR, wagi data[E,H] (fp32) i skwantowane
+// cechy q [N,H,D]. per_head == true: grupa (c, h) ma indeks c*H + h,
+// inaczej grupą jest cały węzeł c.
+struct QuantizedSpmmInput
+{
+    const int64_t *indices;
+    const float *data;
+    const int8_t *q;
+    const float *scale;
+    const int32_t *zero_point;
+    int64_t H;
+    int64_t D;
+    bool per_head;
+};
+
+// Funkcja: spmm_row_segment_int8
+// Dekwantyzacja w pętli gather: waga krawędzi jest od razu mnożona przez
+// skalę sąsiada (ws = data * scale), a punkt zera odejmowany raz na końcu:
+//   out[h,:] = ∑ ws * q[c,h,:] - ∑ ws * zero_point
+// więc w pętli po d zostaje jedno mnożenie-dodawanie na bajt cechy.
+inline void spmm_row_segment_int8(
+    const QuantizedSpmmInput &in,
+    int64_t begin,
+    int64_t end,
+    int64_t h_begin,
+    int64_t h_end,
+    float *out,
+    int64_t out_head_stride)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+
+    for (int64_t h = h_begin; h < h_end; h++)
+    {
+        float *out_head = out + (h - h_begin) * out_head_stride;
+        std::fill(out_head, out_head + D, 0.0f);
+        float bias = 0.0f;
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            int64_t c = in.indices[i];
+            int64_t g = in.per_head ? c * H + h : c;
+            float ws = in.data[i * H + h] * in.scale[g];
+            bias += ws * static_cast<float>(in.zero_point[g]);
+
+            const int8_t *q_head = in.q + (c * H + h) * D;
+#pragma omp simd
+            for (int64_t d = 0; d < D; d++)
+            {
+                out_head[d] += ws * static_cast<float>(q_head[d]);
+            }
+        }
+
+        for (int64_t d = 0; d < D; d++)
+        {
+            out_head[d] -= bias;
+        }
+    }
+}
+
+// Funkcja: spmm_csr_3d_int8_partitioned
+// result[row,h,:] = ∑_{edge w wierszu row} data[edge,h] * dequant(q)[col(edge),h,:]
+// w układzie [N,H,D], z tym samym podziałem merge-path co spmm_csr_3d.
+inline void spmm_csr_3d_int8_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const QuantizedSpmmInput &in,
+    float *result)
+{
+    NodeMajorLayout layout{in.H, in.D};
+    spmm_partitioned_rows(part, indptr, in.H, in.D, result, layout, in.H,
+                          [&](int64_t begin, int64_t end, int64_t h_begin, int64_t h_end, float *out, int64_t out_head_stride)
+    {
+        spmm_row_segment_int8(in, begin, end, h_begin, h_end, out, out_head_stride);
+    });
+}
@@ -0,0 +1,323 @@
+#include "spmm_extension.h"
+#include "reductions.h"
+
+// Funkcja: spmm_csr_3d_reduce
+// Agregacja CSR x [N,H,D] z redukcją sum/mean/max/min (reductions.h):
+//
+// msg[e,h,:]    = data[e,h] * x[col(e),h,:]   (data = None - wagi 1)
+// out[row,h,:]  = reduce_{e w wierszu row} msg[e,h,:]
+//
+// Kilka redukcji naraz (np. ["mean", "max", "min"]) liczonych jest w jednym
+// przejściu po sąsiadach. Wynik to lista: najpierw wartości w kolejności
+// reduces, potem argmax/argmin (numery krawędzi [rows,H,D], -1 dla wierszy bez
+// krawędzi) dla każdego max/min. Backward:
+//   sum/mean - transponowana agregacja (jak spmm_csr_3d), mean z gradientem / deg,
+//   max/min  - gradient tylko do krawędzi z argmax/argmin (index_add bez
+//              ponownego przejścia po grafie).
+// Wejścia fp32.
+
+enum class ReduceKind : int64_t
+{
+    Sum,
+    Mean,
+    Max,
+    Min
+};
+
+static ReduceKind parse_reduce(const std::string &name)
+{
+    if (name == "sum")
+        return ReduceKind::Sum;
+    if (name == "mean")
+        return ReduceKind::Mean;
+    if (name == "max")
+        return ReduceKind::Max;
+    TORCH_CHECK(name == "min", "unknown reduce '", name, "' (expected sum, mean, max or min)");
+    return ReduceKind::Min;
+}
+
+static bool is_arg_reduce(ReduceKind kind)
+{
+    return kind == ReduceKind::Max || kind == ReduceKind::Min;
+}
+
+// odwrotność stopnia wiersza [rows,1,1] (0 dla wierszy bez krawędzi)
+static torch::Tensor inverse_degree(torch::Tensor indptr)
+{
+    auto deg = (indptr.slice(0, 1) - indptr.slice(0, 0, -1)).to(torch::kFloat32);
+    return torch::where(deg > 0, 1.0 / deg, torch::zeros_like(deg)).view({-1, 1, 1});
+}
+
+class SpmmCsr3dReduceFunction : public torch::autograd::Function<SpmmCsr3dReduceFunction>
+{
+public:
+    static torch::autograd::variable_list forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor data,
+        torch::Tensor x,
+        std::vector<std::string> reduces,
+        std::shared_ptr<CsrPartition> partition,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(x.dim() == 3, "x must be 3D [N,H,D]");
+        TORCH_CHECK(x.scalar_type() == torch::kFloat32, "x must be float32");
+        TORCH_CHECK(!reduces.empty(), "reduces must not be empty");
+
+        int64_t num_rows = indptr.size(0) - 1;
+        int64_t E = indices.size(0);
+        int64_t H = x.size(1);
+        int64_t D = x.size(2);
+        if (data.defined())
+        {
+            TORCH_CHECK(data.dim() == 2 && data.size(0) == E && data.size(1) == H, "data must be [E,H] with H matching x");
+            TORCH_CHECK(data.scalar_type() == torch::kFloat32, "data must be float32");
+            data = data.contiguous();
+        }
+
+        std::vector<int64_t> kinds;
+        unsigned flags = 0;
+        for (const auto &name : reduces)
+        {
+            ReduceKind kind = parse_reduce(name);
+            for (int64_t k : kinds)
+            {
+                TORCH_CHECK(k != int64_t(kind), "reduce '", name, "' given more than once");
+            }
+            kinds.push_back(int64_t(kind));
+            flags |= kind == ReduceKind::Max ? REDUCE_MAX : kind == ReduceKind::Min ? REDUCE_MIN : REDUCE_SUM;
+        }
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        x = x.contiguous();
+
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+        TORCH_CHECK(part.num_rows == num_rows && part.nnz == E, "partition was built for a different graph");
+
+        SPMM_OP_SCOPE(op, "spmm_csr_3d_reduce", indices, indptr, x);
+        int64_t num_outputs = __builtin_popcount(flags);
+        op.work(E, spmm_stats::spmm_bytes(num_rows, E, H, D, 4) - (data.defined() ? 0 : 4 * E * H) +
+                       (num_outputs - 1) * 4 * num_rows * H * D +
+                       8 * num_rows * H * D * int64_t(__builtin_popcount(flags & (REDUCE_MAX | REDUCE_MIN))));
+
+        // stan redukcji: sum (także dla mean), max + argmax, min + argmin
+        auto options = x.options();
+        torch::Tensor sum, max, argmax, min, argmin;
+        if (flags & REDUCE_SUM)
+        {
+            sum = torch::empty({num_rows, H, D}, options);
+        }
+        if (flags & REDUCE_MAX)
+        {
+            max = torch::empty({num_rows, H, D}, options);
+            argmax = torch::empty({num_rows, H, D}, options.dtype(torch::kInt64));
+        }
+        if (flags & REDUCE_MIN)
+        {
+            min = torch::empty({num_rows, H, D}, options);
+            argmin = torch::empty({num_rows, H, D}, options.dtype(torch::kInt64));
+        }
+
+        ReduceInput in{indices.data_ptr<int64_t>(), data.defined() ? data.data_ptr<float>() : nullptr,
+                       x.data_ptr<float>(), H, D};
+        ReduceOutput out{
+            sum.defined() ? sum.data_ptr<float>() : nullptr,
+            max.defined() ? max.data_ptr<float>() : nullptr,
+            argmax.defined() ? argmax.data_ptr<int64_t>() : nullptr,
+            min.defined() ? min.data_ptr<float>() : nullptr,
+            argmin.defined() ? argmin.data_ptr<int64_t>() : nullptr};
+        reduce_csr_3d_partitioned(part, indptr.data_ptr<int64_t>(), in, flags, out);
+
+        torch::autograd::variable_list values, args;
+        for (int64_t k : kinds)
+        {
+            switch (ReduceKind(k))
+            {
+            case ReduceKind::Sum:
+                values.push_back(sum);
+                break;
+            case ReduceKind::Mean:
+                values.push_back(sum * inverse_degree(indptr));
+                break;
+            case ReduceKind::Max:
+                values.push_back(max);
+                args.push_back(argmax);
+                break;
+            case ReduceKind::Min:
+                values.push_back(min);
+                args.push_back(argmin);
+                break;
+            }
+        }
+        for (const auto &v : values)
+        {
+            op.alloc(v.nbytes());
+        }
+        for (const auto &a : args)
+        {
+            op.alloc(a.nbytes());
+        }
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        if (graph)
+        {
+            t_indptr = graph->t_indptr;
+            t_rows = graph->t_rows;
+            t_perm = graph->t_perm;
+            ctx->saved_data["row_start_t"] = graph->partition_t.row_start;
+            ctx->saved_data["edge_start_t"] = graph->partition_t.edge_start;
+        }
+
+        torch::autograd::variable_list to_save{indices, indptr, data, x, t_indptr, t_rows, t_perm};
+        to_save.insert(to_save.end(), args.begin(), args.end());
+        ctx->save_for_backward(to_save);
+        ctx->saved_data["kinds"] = kinds;
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+        ctx->mark_non_differentiable(args);
+
+        values.insert(values.end(), args.begin(), args.end());
+        return values;
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto data = saved[2];
+        auto x = saved[3];
+        std::vector<int64_t> kinds = ctx->saved_data["kinds"].toIntVector();
+
+        int64_t E = indices.size(0);
+        int64_t H = x.size(1);
+        int64_t D = x.size(2);
+        bool need_data = data.defined() && ctx->needs_input_grad(2);
+        bool need_x = ctx->needs_input_grad(3);
+
+        // sum i mean: jeden gradient "liniowy" lin [rows,H,D] dla obu
+        torch::Tensor lin;
+        std::vector<std::pair<torch::Tensor, torch::Tensor>> selected; // (arg, grad) dla max/min
+        size_t next_arg = 7;
+        for (size_t k = 0; k < kinds.size(); k++)
+        {
+            ReduceKind kind = ReduceKind(kinds[k]);
+            torch::Tensor arg = is_arg_reduce(kind) ? saved[next_arg++] : torch::Tensor();
+            const auto &g = grad_outputs[k];
+            if (!g.defined())
+            {
+                continue;
+            }
+            if (is_arg_reduce(kind))
+            {
+                selected.emplace_back(arg, g);
+                continue;
+            }
+            auto g_lin = kind == ReduceKind::Mean ? g * inverse_degree(indptr) : g;
+            lin = lin.defined() ? lin + g_lin : g_lin;
+        }
+
+        torch::Tensor grad_data, grad_x;
+
+        if (lin.defined())
+        {
+            lin = lin.to(torch::kFloat32).contiguous();
+            CsrPartition part;
+            part.num_rows = indptr.size(0) - 1;
+            part.nnz = E;
+            part.row_start = ctx->saved_data["row_start"].toIntVector();
+            part.edge_start = ctx->saved_data["edge_start"].toIntVector();
+
+            if (need_data)
+            {
+                grad_data = spmm_csr_3d_backward_data(indices, indptr, lin, x, part);
+            }
+            if (need_x)
+            {
+                auto w = data.defined() ? data : torch::ones({E, H}, x.options());
+                if (saved[4].defined())
+                {
+                    CsrPartition part_t;
+                    part_t.num_rows = saved[4].size(0) - 1;
+                    part_t.nnz = E;
+                    part_t.row_start = ctx->saved_data["row_start_t"].toIntVector();
+                    part_t.edge_start = ctx->saved_data["edge_start_t"].toIntVector();
+                    grad_x = spmm_csr_3d_backward_dense(saved[4], saved[5], saved[6], w, lin, part_t);
+                }
+                else
+                {
+                    auto t = csr_transpose(indices, indptr, x.size(0));
+                    grad_x = spmm_csr_3d_backward_dense(t[0], t[1], t[2], w, lin, make_partition(t[0], 0));
+                }
+            }
+        }
+
+        if (!selected.empty())
+        {
+            if (need_data && !grad_data.defined())
+            {
+                grad_data = torch::zeros({E, H}, x.options());
+            }
+            if (need_x && !grad_x.defined())
+            {
+                grad_x = torch::zeros_like(x);
+            }
+
+            // pozycja [row,h,d] z wybraną krawędzią e: gradient trafia do
+            // x[col(e),h,d] (z wagą data[e,h]) i do data[e,h] (z x[col(e),h,d])
+            for (const auto &sel : selected)
+            {
+                auto arg = sel.first.reshape(-1);
+                auto pos = (arg >= 0).nonzero().squeeze(1);
+                auto e = arg.index_select(0, pos);
+                auto g = sel.second.to(torch::kFloat32).reshape(-1).index_select(0, pos);
+                auto hd = pos.remainder(H * D);
+                auto eh = e * H + torch::div(hd, D, "floor");
+                auto x_pos = indices.index_select(0, e) * (H * D) + hd;
+
+                if (need_x)
+                {
+                    auto w = data.defined() ? data.reshape(-1).index_select(0, eh) : torch::ones_like(g);
+                    grad_x.view(-1).index_add_(0, x_pos, g * w);
+                }
+                if (need_data)
+                {
+                    grad_data.view(-1).index_add_(0, eh, g * x.reshape(-1).index_select(0, x_pos));
+                }
+            }
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_data, grad_x, torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    }
+};
+
+std::vector<torch::Tensor> spmm_csr_3d_reduce(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    c10::optional<torch::Tensor> data,
+    torch::Tensor x,
+    const std::vector<std::string> &reduces,
+    std::shared_ptr<CsrPartition> partition)
+{
+    return SpmmCsr3dReduceFunction::apply(indices, indptr, data.value_or(torch::Tensor()), x, reduces, partition,
+                                          std::shared_ptr<CSRGraph>());
+}
+
+std::vector<torch::Tensor> spmm_csr_3d_reduce_graph(
+    std::shared_ptr<CSRGraph> graph,
+    c10::optional<torch::Tensor> data,
+    torch::Tensor x,
+    const std::vector<std::string> &reduces)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(x.dim() == 3 && x.size(0) == graph->num_cols, "x must be 3D [num_cols,H,D]");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SpmmCsr3dReduceFunction::apply(graph->indices, graph->indptr, data.value_or(torch::Tensor()), x, reduces,
+                                          partition, graph);
+}
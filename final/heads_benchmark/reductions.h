@@ -0,0 +1,255 @@
+#pragma once
+
+#include "csr_partition.h"
+#include "instrumentation.h"
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Agregacja CSR x [N,H,D] z innymi redukcjami niż suma:
+//   sum[row,h,:]  = ∑    msg(e,h,:)
+//   mean[row,h,:] = sum / deg(row)
+//   max[row,h,:]  = max  msg(e,h,:),  argmax - numer krawędzi e (pozycja w CSR)
+//   min[row,h,:]  = min  msg(e,h,:),  argmin - jw.
+// gdzie msg(e,h,:) = data[e,h] * x[col(e),h,:] (albo x[col(e),h,:] bez wag),
+// po krawędziach e wiersza row. Kilka redukcji liczonych jest w jednym
+// przejściu po sąsiadach (tryb "multi", np. mean + max + min jak w PNA).
+//
+// Wiersz bez krawędzi daje 0 i arg = -1 (jak torch_scatter). Przy remisie
+// wygrywa pierwsza krawędź wiersza. argmax/argmin wystarczą do backwardu:
+// gradient trafia tylko do wybranej krawędzi, bez ponownego przejścia po grafie.
+
+enum ReduceFlags : unsigned
+{
+    REDUCE_SUM = 1, // także mean (sum / deg)
+    REDUCE_MAX = 2,
+    REDUCE_MIN = 4
+};
+
+struct ReduceInput
+{
+    const int64_t *indices;
+    const float *data; // [E,H] albo nullptr (wagi 1)
+    const float *x;    // [N,H,D]
+    int64_t H;
+    int64_t D;
+};
+
+// Wskaźniki na wyniki [rows,H,D]; nullptr dla redukcji, które nie są liczone.
+struct ReduceOutput
+{
+    float *sum;
+    float *max;
+    int64_t *argmax;
+    float *min;
+    int64_t *argmin;
+};
+
+// Funkcja: reduce_row_segment
+// Stan redukcji krawędzi [begin, end) jednego wiersza (H*D wartości na
+// redukcję, od pozycji offset w każdym buforze). Stan jest nadpisywany.
+template <bool kSum, bool kMax, bool kMin>
+inline void reduce_row_segment(
+    const ReduceInput &in,
+    int64_t begin,
+    int64_t end,
+    const ReduceOutput &out,
+    int64_t offset)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+    const int64_t HD = H * D;
+    float *sum = kSum ? out.sum + offset : nullptr;
+    float *mx = kMax ? out.max + offset : nullptr;
+    int64_t *amx = kMax ? out.argmax + offset : nullptr;
+    float *mn = kMin ? out.min + offset : nullptr;
+    int64_t *amn = kMin ? out.argmin + offset : nullptr;
+
+    if (kSum)
+    {
+        std::fill(sum, sum + HD, 0.0f);
+    }
+    if (kMax)
+    {
+        std::fill(mx, mx + HD, -std::numeric_limits<float>::infinity());
+        std::fill(amx, amx + HD, int64_t(-1));
+    }
+    if (kMin)
+    {
+        std::fill(mn, mn + HD, std::numeric_limits<float>::infinity());
+        std::fill(amn, amn + HD, int64_t(-1));
+    }
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        const float *x_row = in.x + in.indices[i] * HD;
+
+        for (int64_t h = 0; h < H; h++)
+        {
+            const float w = in.data ? in.data[i * H + h] : 1.0f;
+            const float *xr = x_row + h * D;
+            const int64_t o = h * D;
+
+            if (kSum)
+            {
+#pragma omp simd
+                for (int64_t d = 0; d < D; d++)
+                {
+                    sum[o + d] += w * xr[d];
+                }
+            }
+            if (kMax)
+            {
+#pragma omp simd
+                for (int64_t d = 0; d < D; d++)
+                {
+                    float v = w * xr[d];
+                    bool better = v > mx[o + d];
+                    mx[o + d] = better ? v : mx[o + d];
+                    amx[o + d] = better ? i : amx[o + d];
+                }
+            }
+            if (kMin)
+            {
+#pragma omp simd
+                for (int64_t d = 0; d < D; d++)
+                {
+                    float v = w * xr[d];
+                    bool better = v < mn[o + d];
+                    mn[o + d] = better ? v : mn[o + d];
+                    amn[o + d] = better ? i : amn[o + d];
+                }
+            }
+        }
+    }
+}
+
+// Dołączenie stanu wcześniejszego fragmentu wiersza (src, carry) do stanu
+// późniejszego (dst). src wygrywa remisy, bo jego krawędzie są wcześniej.
+template <bool kSum, bool kMax, bool kMin>
+inline void reduce_merge(const ReduceOutput &dst, int64_t dst_offset, const ReduceOutput &src, int64_t src_offset, int64_t HD)
+{
+    for (int64_t k = 0; k < HD; k++)
+    {
+        if (kSum)
+        {
+            dst.sum[dst_offset + k] += src.sum[src_offset + k];
+        }
+        if (kMax)
+        {
+            int64_t a = src.argmax[src_offset + k];
+            if (a >= 0 && (dst.argmax[dst_offset + k] < 0 || src.max[src_offset + k] >= dst.max[dst_offset + k]))
+            {
+                dst.max[dst_offset + k] = src.max[src_offset + k];
+                dst.argmax[dst_offset + k] = a;
+            }
+        }
+        if (kMin)
+        {
+            int64_t a = src.argmin[src_offset + k];
+            if (a >= 0 && (dst.argmin[dst_offset + k] < 0 || src.min[src_offset + k] <= dst.min[dst_offset + k]))
+            {
+                dst.min[dst_offset + k] = src.min[src_offset + k];
+                dst.argmin[dst_offset + k] = a;
+            }
+        }
+    }
+}
+
+// Funkcja: reduce_csr_3d_partitioned_impl
+// Ten sam schemat co spmm_partitioned_rows (spmm_kernels.h): części
+// merge-path równolegle, fragment wiersza-huba z poprzedniej części w buforze
+// carry, carry dołączane szeregowo po pętli. Tu carry to pełny stan redukcji,
+// a nie suma częściowa, więc łączenie to reduce_merge zamiast +=.
+template <bool kSum, bool kMax, bool kMin>
+inline void reduce_csr_3d_partitioned_impl(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const ReduceInput &in,
+    const ReduceOutput &out)
+{
+    const int64_t HD = in.H * in.D;
+    const int64_t P = part.num_parts();
+
+    std::vector<float> carry_sum(kSum ? P * HD : 0);
+    std::vector<float> carry_max(kMax ? P * HD : 0);
+    std::vector<int64_t> carry_argmax(kMax ? P * HD : 0);
+    std::vector<float> carry_min(kMin ? P * HD : 0);
+    std::vector<int64_t> carry_argmin(kMin ? P * HD : 0);
+    std::vector<int64_t> carry_row(P, -1);
+    ReduceOutput carry{carry_sum.data(), carry_max.data(), carry_argmax.data(), carry_min.data(), carry_argmin.data()};
+    spmm_stats::record_alloc(P * HD * int64_t((kSum ? 4 : 0) + (kMax ? 12 : 0) + (kMin ? 12 : 0)));
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < P; p++)
+    {
+        spmm_stats::BusyScope busy(op);
+        part.for_each_segment(p, indptr, [&](int64_t p, int64_t row, int64_t begin, int64_t end, bool row_ends_here)
+        {
+            if (row_ends_here)
+            {
+                reduce_row_segment<kSum, kMax, kMin>(in, begin, end, out, row * HD);
+            }
+            else
+            {
+                carry_row[p] = row;
+                reduce_row_segment<kSum, kMax, kMin>(in, begin, end, carry, p * HD);
+            }
+        });
+    }
+
+    // części w kolejności malejącej: każde carry jest wcześniejsze niż to,
+    // co jest już w wyniku wiersza (część kończąca wiersz i późniejsze carry)
+    for (int64_t p = P - 1; p >= 0; p--)
+    {
+        if (carry_row[p] >= 0)
+        {
+            reduce_merge<kSum, kMax, kMin>(out, carry_row[p] * HD, carry, p * HD, HD);
+        }
+    }
+}
+
+// Funkcja: reduce_csr_3d_partitioned
+// flags - suma REDUCE_*; liczone są tylko redukcje z flags (jedno przejście).
+// Wynik sum to suma (mean dzieli przez stopień wywołujący), a max/min dla
+// wierszy bez krawędzi są zerowane.
+inline void reduce_csr_3d_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const ReduceInput &in,
+    unsigned flags,
+    const ReduceOutput &out)
+{
+    switch (flags)
+    {
+    case REDUCE_SUM: reduce_csr_3d_partitioned_impl<true, false, false>(part, indptr, in, out); break;
+    case REDUCE_MAX: reduce_csr_3d_partitioned_impl<false, true, false>(part, indptr, in, out); break;
+    case REDUCE_MIN: reduce_csr_3d_partitioned_impl<false, false, true>(part, indptr, in, out); break;
+    case REDUCE_SUM | REDUCE_MAX: reduce_csr_3d_partitioned_impl<true, true, false>(part, indptr, in, out); break;
+    case REDUCE_SUM | REDUCE_MIN: reduce_csr_3d_partitioned_impl<true, false, true>(part, indptr, in, out); break;
+    case REDUCE_MAX | REDUCE_MIN: reduce_csr_3d_partitioned_impl<false, true, true>(part, indptr, in, out); break;
+    case REDUCE_SUM | REDUCE_MAX | REDUCE_MIN: reduce_csr_3d_partitioned_impl<true, true, true>(part, indptr, in, out); break;
+    default: return;
+    }
+
+    // wiersze bez krawędzi: 0 zamiast ±inf
+    const int64_t HD = in.H * in.D;
+    if (flags & (REDUCE_MAX | REDUCE_MIN))
+    {
+#pragma omp parallel for schedule(static)
+        for (int64_t k = 0; k < part.num_rows * HD; k++)
+        {
+            if ((flags & REDUCE_MAX) && out.argmax[k] < 0)
+            {
+                out.max[k] = 0.0f;
+            }
+            if ((flags & REDUCE_MIN) && out.argmin[k] < 0)
+            {
+                out.min[k] = 0.0f;
+            }
+        }
+    }
+}
@@ -0,0 +1,174 @@
+#include "spmm_extension.h"
+#include "reorder.h"
+
+// Przenumerowanie wierzchołków dla lokalności odczytów dense[col] w
+// spmm_csr_3d (reorder.h). Graf jest przenumerowywany raz, a cechy węzłów
+// i wyniki przechodzą między numeracjami przez permute_nodes/unpermute_nodes.
+//
+// Metody:
+//   "rcm"       - reverse Cuthill-McKee (mała szerokość pasma),
+//   "degree"    - malejąco po stopniu (gorące węzły obok siebie),
+//   "community" - społeczności z propagacji etykiet, w środku kolejność RCM,
+//   "none"      - identyczność.
+
+static void check_square_csr(const torch::Tensor &indptr, const torch::Tensor &indices)
+{
+    TORCH_CHECK(indptr.dim() == 1 && indptr.size(0) >= 1, "indptr must be 1D with at least one element");
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.scalar_type() == torch::kInt64 && indices.scalar_type() == torch::kInt64,
+                "indptr and indices must be int64");
+    int64_t N = indptr.size(0) - 1;
+    TORCH_CHECK(indptr[0].item<int64_t>() == 0 && indptr[N].item<int64_t>() == indices.size(0),
+                "indptr must start at 0 and end at the number of edges");
+    if (indices.size(0) > 0)
+    {
+        TORCH_CHECK(indices.min().item<int64_t>() >= 0 && indices.max().item<int64_t>() < N,
+                    "reordering needs a square graph: indices out of range [0, num_rows)");
+    }
+}
+
+// Funkcja: reorder_permutation
+// Zwraca perm [N] (perm[new] = old) wybraną metodą.
+torch::Tensor reorder_permutation(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    const std::string &method,
+    int64_t max_iterations)
+{
+    check_square_csr(indptr, indices);
+    indptr = indptr.contiguous();
+    indices = indices.contiguous();
+    int64_t N = indptr.size(0) - 1;
+
+    if (method == "none")
+    {
+        return torch::arange(N, indptr.options());
+    }
+    TORCH_CHECK(method == "rcm" || method == "degree" || method == "community",
+                "method must be one of: rcm, degree, community, none");
+    TORCH_CHECK(max_iterations >= 0, "max_iterations must be non-negative");
+
+    auto perm = torch::empty({N}, indptr.options());
+
+    auto t = csr_transpose(indices, indptr, N);
+    auto t_indptr = t[0];
+    auto t_rows = t[1];
+    auto degree = torch::empty({N}, indptr.options());
+    symmetric_degree(indptr.data_ptr<int64_t>(), t_indptr.data_ptr<int64_t>(), N, degree.data_ptr<int64_t>());
+
+    if (method == "degree")
+    {
+        degree_order(degree.data_ptr<int64_t>(), N, perm.data_ptr<int64_t>());
+        return perm;
+    }
+
+    rcm_order(indptr.data_ptr<int64_t>(), indices.data_ptr<int64_t>(),
+              t_indptr.data_ptr<int64_t>(), t_rows.data_ptr<int64_t>(),
+              degree.data_ptr<int64_t>(), N, perm.data_ptr<int64_t>());
+    if (method == "rcm")
+    {
+        return perm;
+    }
+
+    auto rcm = perm;
+    perm = torch::empty({N}, indptr.options());
+    community_order(indptr.data_ptr<int64_t>(), indices.data_ptr<int64_t>(),
+                    t_indptr.data_ptr<int64_t>(), t_rows.data_ptr<int64_t>(),
+                    degree.data_ptr<int64_t>(), rcm.data_ptr<int64_t>(), N,
+                    static_cast<int>(max_iterations), perm.data_ptr<int64_t>());
+    return perm;
+}
+
+// Funkcja: permute_csr
+// Przenumerowuje wzorzec CSR wg perm (perm[new] = old) dla wierszy i kolumn.
+// Zwraca [new_indptr, new_indices, edge_perm], gdzie edge_perm[new_e] = old_e
+// (dane krawędzi: data.index_select(0, edge_perm)). Kolumny w wierszach
+// wyniku są posortowane rosnąco.
+std::vector<torch::Tensor> permute_csr(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    torch::Tensor perm)
+{
+    check_square_csr(indptr, indices);
+    int64_t N = indptr.size(0) - 1;
+    TORCH_CHECK(perm.dim() == 1 && perm.size(0) == N && perm.scalar_type() == torch::kInt64,
+                "perm must be int64 [num_rows]");
+    indptr = indptr.contiguous();
+    indices = indices.contiguous();
+    perm = perm.contiguous();
+
+    auto inv_perm = torch::full({N}, -1, perm.options());
+    inv_perm.index_put_({perm}, torch::arange(N, perm.options()));
+    if (N > 0)
+    {
+        TORCH_CHECK(inv_perm.min().item<int64_t>() >= 0, "perm must be a permutation of [0, num_rows)");
+    }
+
+    auto new_indptr = torch::empty_like(indptr);
+    auto new_indices = torch::empty_like(indices);
+    auto edge_perm = torch::empty_like(indices);
+    permute_csr_pattern(indptr.data_ptr<int64_t>(), indices.data_ptr<int64_t>(),
+                        perm.data_ptr<int64_t>(), inv_perm.data_ptr<int64_t>(), N,
+                        new_indptr.data_ptr<int64_t>(), new_indices.data_ptr<int64_t>(),
+                        edge_perm.data_ptr<int64_t>());
+    return {new_indptr, new_indices, edge_perm};
+}
+
+// Funkcja: reorder_graph
+// reorder_permutation + permute_csr + CSRGraph::build w jednym kroku.
+// Zwrócony graf ma ustawione perm/inv_perm/edge_perm, więc cechy węzłów
+// przenosi się raz przez permute_nodes, a wyniki modelu wracają do
+// oryginalnej numeracji przez unpermute_nodes.
+std::shared_ptr<CSRGraph> reorder_graph(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    const std::string &method,
+    int64_t num_parts,
+    int64_t max_iterations)
+{
+    auto perm = reorder_permutation(indptr, indices, method, max_iterations);
+    auto p = permute_csr(indptr, indices, perm);
+    auto graph = CSRGraph::build(p[0], p[1], -1, num_parts, perm);
+    graph->edge_perm = p[2];
+    return graph;
+}
+
+// Funkcja: permute_nodes
+// x [N, ...] w oryginalnej numeracji -> numeracja grafu (x[perm]).
+torch::Tensor permute_nodes(std::shared_ptr<CSRGraph> graph, torch::Tensor x)
+{
+    TORCH_CHECK(x.dim() >= 1 && x.size(0) == graph->num_rows, "x first dim must match num_rows");
+    if (!graph->perm.defined())
+    {
+        return x;
+    }
+    return x.index_select(0, graph->perm);
+}
+
+// Funkcja: unpermute_nodes
+// y [N, ...] w numeracji grafu -> oryginalna numeracja (y[inv_perm]).
+torch::Tensor unpermute_nodes(std::shared_ptr<CSRGraph> graph, torch::Tensor y)
+{
+    TORCH_CHECK(y.dim() >= 1 && y.size(0) == graph->num_rows, "y first dim must match num_rows");
+    if (!graph->perm.defined())
+    {
+        return y;
+    }
+    return y.index_select(0, graph->inv_perm);
+}
+
+// Funkcja: locality_report
+// Miary lokalności (LocalityStats) dla danej numeracji grafu, do porównania
+// przed i po przenumerowaniu.
+std::unordered_map<std::string, double> locality_report(torch::Tensor indptr, torch::Tensor indices)
+{
+    check_square_csr(indptr, indices);
+    indptr = indptr.contiguous();
+    indices = indices.contiguous();
+    auto stats = locality_stats(indptr.data_ptr<int64_t>(), indices.data_ptr<int64_t>(), indptr.size(0) - 1);
+    return {
+        {"bandwidth", double(stats.bandwidth)},
+        {"mean_distance", stats.mean_distance},
+        {"mean_gap", stats.mean_gap},
+    };
+}
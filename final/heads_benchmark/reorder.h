@@ -0,0 +1,342 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "coo_csr.h"
+
+// Przenumerowanie wierzchołków grafu dla lepszej lokalności odczytów
+// dense[col] w spmm_csr_3d. Wszystkie funkcje działają na grafie
+// kwadratowym [N x N] i na jego sumie z transpozycją (CSR + CSC), czyli
+// sąsiedzi v to indices[indptr[v]..] oraz t_rows[t_indptr[v]..].
+//
+// Wynikiem jest perm [N] z perm[new] = old.
+
+// Funkcja: symmetric_degree
+// Stopień v w grafie A + A^T (krawędzie w obu kierunkach liczone osobno).
+inline void symmetric_degree(
+    const int64_t *indptr,
+    const int64_t *t_indptr,
+    int64_t N,
+    int64_t *degree)
+{
+#pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < N; v++)
+    {
+        degree[v] = (indptr[v + 1] - indptr[v]) + (t_indptr[v + 1] - t_indptr[v]);
+    }
+}
+
+// Funkcja: degree_order
+// Wierzchołki malejąco po stopniu (najpierw węzły o dużym stopniu, których
+// cechy są czytane najczęściej, więc trafiają obok siebie w pamięci).
+// Równe stopnie zachowują oryginalną kolejność.
+inline void degree_order(const int64_t *degree, int64_t N, int64_t *perm)
+{
+    int64_t max_degree = 0;
+    for (int64_t v = 0; v < N; v++)
+    {
+        max_degree = std::max(max_degree, degree[v]);
+    }
+
+    std::vector<int64_t> key(N);
+    std::vector<int64_t> ptr(max_degree + 2);
+#pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < N; v++)
+    {
+        key[v] = max_degree - degree[v];
+    }
+    stable_counting_sort(key.data(), nullptr, N, max_degree + 1, ptr.data(), perm);
+}
+
+// Funkcja: rcm_order
+// Reverse Cuthill-McKee: BFS po A + A^T, w którym nieodwiedzeni sąsiedzi
+// są dokładani rosnąco po stopniu, a wynik jest odwracany. Każda składowa
+// spójna zaczyna się od nieodwiedzonego wierzchołka o najmniejszym stopniu.
+// Zmniejsza szerokość pasma, więc sąsiedzi wiersza mają bliskie numery.
+//
+// Przebieg jest sekwencyjny (kolejka BFS to sam perm), ale robi się go raz
+// przy przygotowaniu grafu.
+inline void rcm_order(
+    const int64_t *indptr,
+    const int64_t *indices,
+    const int64_t *t_indptr,
+    const int64_t *t_rows,
+    const int64_t *degree,
+    int64_t N,
+    int64_t *perm)
+{
+    int64_t max_degree = 0;
+    for (int64_t v = 0; v < N; v++)
+    {
+        max_degree = std::max(max_degree, degree[v]);
+    }
+
+    // kandydaci na początek składowej: rosnąco po stopniu
+    std::vector<int64_t> start(N);
+    std::vector<int64_t> ptr(max_degree + 2);
+    stable_counting_sort(degree, nullptr, N, max_degree + 1, ptr.data(), start.data());
+
+    std::vector<char> visited(N, 0);
+    std::vector<int64_t> next;
+    int64_t head = 0;
+    int64_t tail = 0;
+
+    auto push_neighbors = [&](const int64_t *begin, const int64_t *end)
+    {
+        for (const int64_t *p = begin; p < end; p++)
+        {
+            if (!visited[*p])
+            {
+                visited[*p] = 1;
+                next.push_back(*p);
+            }
+        }
+    };
+
+    for (int64_t s = 0; s < N; s++)
+    {
+        if (visited[start[s]])
+        {
+            continue;
+        }
+        visited[start[s]] = 1;
+        perm[tail++] = start[s];
+
+        while (head < tail)
+        {
+            int64_t v = perm[head++];
+            next.clear();
+            push_neighbors(indices + indptr[v], indices + indptr[v + 1]);
+            push_neighbors(t_rows + t_indptr[v], t_rows + t_indptr[v + 1]);
+            std::sort(next.begin(), next.end(), [&](int64_t a, int64_t b)
+                      { return degree[a] != degree[b] ? degree[a] < degree[b] : a < b; });
+            for (int64_t u : next)
+            {
+                perm[tail++] = u;
+            }
+        }
+    }
+
+    std::reverse(perm, perm + N);
+}
+
+// Funkcja: community_order
+// Uproszczony wariant Rabbit Order: społeczności wyznaczane propagacją
+// etykiet po A + A^T, potem wierzchołki grupowane po społeczności.
+//
+// W każdej iteracji wierzchołki są przeglądane rosnąco po stopniu
+// (jak w Rabbit Order - małe węzły dołączają do większych) i przejmują
+// najczęstszą etykietę sąsiadów; remis rozstrzyga obecna etykieta, a potem
+// mniejsza etykieta, więc wynik jest deterministyczny. Kończy się po
+// max_iterations albo gdy nic się nie zmienia.
+//
+// Wierzchołki są potem układane stabilnie po społeczności względem kolejności
+// bazowej order (np. z rcm_order), więc propagacja, która zleje dużą składową
+// w jedną społeczność, nie psuje lokalności wewnątrz niej. Społeczności
+// dostają numery w kolejności pierwszego wystąpienia w order.
+inline void community_order(
+    const int64_t *indptr,
+    const int64_t *indices,
+    const int64_t *t_indptr,
+    const int64_t *t_rows,
+    const int64_t *degree,
+    const int64_t *order,
+    int64_t N,
+    int max_iterations,
+    int64_t *perm)
+{
+    int64_t max_degree = 0;
+    for (int64_t v = 0; v < N; v++)
+    {
+        max_degree = std::max(max_degree, degree[v]);
+    }
+
+    std::vector<int64_t> visit(N);
+    std::vector<int64_t> ptr(std::max<int64_t>(max_degree, N) + 2);
+    stable_counting_sort(degree, nullptr, N, max_degree + 1, ptr.data(), visit.data());
+
+    std::vector<int64_t> label(N);
+    for (int64_t v = 0; v < N; v++)
+    {
+        label[v] = v;
+    }
+
+    // licznik etykiet sąsiadów: count jest zerowany tylko na touched
+    std::vector<int64_t> count(N, 0);
+    std::vector<int64_t> touched;
+
+    auto count_labels = [&](const int64_t *begin, const int64_t *end)
+    {
+        for (const int64_t *p = begin; p < end; p++)
+        {
+            int64_t l = label[*p];
+            if (count[l]++ == 0)
+            {
+                touched.push_back(l);
+            }
+        }
+    };
+
+    for (int it = 0; it < max_iterations; it++)
+    {
+        bool changed = false;
+        for (int64_t i = 0; i < N; i++)
+        {
+            int64_t v = visit[i];
+            touched.clear();
+            count_labels(indices + indptr[v], indices + indptr[v + 1]);
+            count_labels(t_rows + t_indptr[v], t_rows + t_indptr[v + 1]);
+            if (touched.empty())
+            {
+                continue;
+            }
+
+            int64_t best_count = 0;
+            for (int64_t l : touched)
+            {
+                best_count = std::max(best_count, count[l]);
+            }
+            int64_t best = label[v];
+            if (count[best] != best_count)
+            {
+                best = N;
+                for (int64_t l : touched)
+                {
+                    if (count[l] == best_count && l < best)
+                    {
+                        best = l;
+                    }
+                }
+            }
+            for (int64_t l : touched)
+            {
+                count[l] = 0;
+            }
+
+            if (best != label[v])
+            {
+                label[v] = best;
+                changed = true;
+            }
+        }
+        if (!changed)
+        {
+            break;
+        }
+    }
+
+    // numeracja społeczności w kolejności pierwszego wystąpienia w order
+    std::vector<int64_t> compact(N, -1);
+    std::vector<int64_t> community(N);
+    int64_t num_communities = 0;
+    for (int64_t i = 0; i < N; i++)
+    {
+        int64_t l = label[order[i]];
+        if (compact[l] < 0)
+        {
+            compact[l] = num_communities++;
+        }
+    }
+#pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < N; v++)
+    {
+        community[v] = compact[label[v]];
+    }
+
+    stable_counting_sort(community.data(), order, N, num_communities, ptr.data(), perm);
+}
+
+// Funkcja: permute_csr_pattern
+// Przenumerowuje graf: nowy wiersz i to stary wiersz perm[i], kolumna c
+// przechodzi na inv_perm[c], a kolumny w wierszu są sortowane rosnąco.
+// edge_perm[new_e] = old_e pozwala przenieść dane krawędzi (data[edge_perm]).
+// new_indptr musi mieć N+1, new_indices i edge_perm - E elementów.
+inline void permute_csr_pattern(
+    const int64_t *indptr,
+    const int64_t *indices,
+    const int64_t *perm,
+    const int64_t *inv_perm,
+    int64_t N,
+    int64_t *new_indptr,
+    int64_t *new_indices,
+    int64_t *edge_perm)
+{
+    new_indptr[0] = 0;
+    for (int64_t i = 0; i < N; i++)
+    {
+        new_indptr[i + 1] = new_indptr[i] + (indptr[perm[i] + 1] - indptr[perm[i]]);
+    }
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int64_t i = 0; i < N; i++)
+    {
+        int64_t begin = new_indptr[i];
+        int64_t end = new_indptr[i + 1];
+        int64_t old_begin = indptr[perm[i]];
+        for (int64_t k = begin; k < end; k++)
+        {
+            edge_perm[k] = old_begin + (k - begin);
+        }
+        std::sort(edge_perm + begin, edge_perm + end, [&](int64_t a, int64_t b)
+                  { return inv_perm[indices[a]] != inv_perm[indices[b]] ? inv_perm[indices[a]] < inv_perm[indices[b]] : a < b; });
+        for (int64_t k = begin; k < end; k++)
+        {
+            new_indices[k] = inv_perm[indices[edge_perm[k]]];
+        }
+    }
+}
+
+// Struktura: LocalityStats
+// Miary lokalności odczytów dense[col] dla danej numeracji:
+//   bandwidth     - max |row - col| (szerokość pasma macierzy),
+//   mean_distance - średnie |row - col| po krawędziach,
+//   mean_gap      - średnia odległość między kolejnymi (posortowanymi)
+//                   kolumnami w wierszu, czyli skok adresu między kolejnymi
+//                   odczytami w jądrze; 1 oznacza odczyt ciągły.
+struct LocalityStats
+{
+    int64_t bandwidth = 0;
+    double mean_distance = 0.0;
+    double mean_gap = 0.0;
+};
+
+inline LocalityStats locality_stats(const int64_t *indptr, const int64_t *indices, int64_t N)
+{
+    int64_t bandwidth = 0;
+    double distance = 0.0;
+    double gap = 0.0;
+    int64_t gaps = 0;
+
+#pragma omp parallel for schedule(dynamic, 256) reduction(max : bandwidth) reduction(+ : distance, gap, gaps)
+    for (int64_t row = 0; row < N; row++)
+    {
+        int64_t prev = -1;
+        for (int64_t i = indptr[row]; i < indptr[row + 1]; i++)
+        {
+            int64_t d = std::abs(row - indices[i]);
+            bandwidth = std::max(bandwidth, d);
+            distance += double(d);
+        }
+        // kolejne kolumny mogą nie być posortowane, więc skok to |różnica|
+        for (int64_t i = indptr[row]; i < indptr[row + 1]; i++)
+        {
+            if (prev >= 0)
+            {
+                gap += double(std::abs(indices[i] - prev));
+                gaps++;
+            }
+            prev = indices[i];
+        }
+    }
+
+    LocalityStats stats;
+    int64_t E = indptr[N];
+    stats.bandwidth = bandwidth;
+    stats.mean_distance = E > 0 ? distance / double(E) : 0.0;
+    stats.mean_gap = gaps > 0 ? gap / double(gaps) : 0.0;
+    return stats;
+}
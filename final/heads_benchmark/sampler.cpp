@@ -0,0 +1,57 @@
+#include "spmm_extension.h"
+
+// Klasa: CsrNeighborSampler
+// Próbkowanie minibatchy (sampler.h) dla grafu trzymanego jako tensory.
+// Graf: wiersz to węzeł docelowy, indices - jego źródła (jak w CSRGraph).
+//
+// sample(seeds, fanouts, batch_key) zwraca
+// [indptr, indices, nodes, edge_ids, hop_offsets] (opis w SampledSubgraph).
+// Lokalny CSR można od razu podać do CSRGraph/spmm_csr_3d, cechy węzłów to
+// x[nodes], a wynik dla seedów to pierwsze hop_offsets[1] wierszy.
+
+CsrNeighborSampler::CsrNeighborSampler(torch::Tensor indptr, torch::Tensor indices, int64_t seed)
+{
+    TORCH_CHECK(indptr.dim() == 1 && indptr.size(0) >= 1, "indptr must be 1D with at least one element");
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.scalar_type() == torch::kInt64 && indices.scalar_type() == torch::kInt64,
+                "indptr and indices must be int64");
+
+    this->indptr = indptr.contiguous();
+    this->indices = indices.contiguous();
+    num_nodes = indptr.size(0) - 1;
+
+    auto indptr_ptr = this->indptr.data_ptr<int64_t>();
+    TORCH_CHECK(indptr_ptr[0] == 0 && indptr_ptr[num_nodes] == indices.size(0),
+                "indptr must start at 0 and end at the number of edges");
+    if (indices.size(0) > 0)
+    {
+        TORCH_CHECK(indices.min().item<int64_t>() >= 0 && indices.max().item<int64_t>() < num_nodes,
+                    "indices out of range [0, num_nodes)");
+    }
+
+    sampler = std::make_unique<NeighborSampler>(
+        indptr_ptr, this->indices.data_ptr<int64_t>(), num_nodes, static_cast<uint64_t>(seed));
+}
+
+std::vector<torch::Tensor> CsrNeighborSampler::sample(
+    torch::Tensor seeds,
+    const std::vector<int64_t> &fanouts,
+    int64_t batch_key)
+{
+    TORCH_CHECK(seeds.dim() == 1 && seeds.scalar_type() == torch::kInt64, "seeds must be int64 1D");
+    seeds = seeds.contiguous();
+    if (seeds.size(0) > 0)
+    {
+        TORCH_CHECK(seeds.min().item<int64_t>() >= 0 && seeds.max().item<int64_t>() < num_nodes,
+                    "seeds out of range [0, num_nodes)");
+    }
+
+    auto sg = sampler->sample(seeds.data_ptr<int64_t>(), seeds.size(0), fanouts, static_cast<uint64_t>(batch_key));
+
+    auto opts = indptr.options();
+    return {torch::tensor(sg.indptr, opts),
+            torch::tensor(sg.indices, opts),
+            torch::tensor(sg.nodes, opts),
+            torch::tensor(sg.edge_ids, opts),
+            torch::tensor(sg.hop_offsets, opts)};
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Próbkowanie sąsiadów (GraphSAGE): k skoków z osobnym fanoutem na skok,
+// wynik jako lokalny, przenumerowany podgraf CSR gotowy dla spmm_csr_3d.
+//
+// Graf wejściowy: CSR, w którym wiersz to węzeł docelowy, a indices to jego
+// źródła (jak w CSRGraph w my_gat_layer.py).
+//
+// Losowanie jest licznikowe (splitmix64 z (seed, batch_key, hop, węzeł,
+// numer losowania)), więc wynik nie zależy od liczby wątków ani od tego,
+// który wątek przetwarza dany węzeł. Ten sam batch_key daje ten sam podgraf.
+
+// Funkcja: sampler_hash
+// splitmix64 - mieszanie 64-bitowe, z którego liczone są losowania.
+inline uint64_t sampler_hash(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t sampler_random(uint64_t seed, uint64_t batch_key, uint64_t hop, uint64_t node, uint64_t draw)
+{
+    uint64_t h = sampler_hash(seed ^ sampler_hash(batch_key));
+    h = sampler_hash(h ^ hop);
+    h = sampler_hash(h ^ node);
+    return sampler_hash(h ^ draw);
+}
+
+// Struktura: SampledSubgraph
+// Lokalny podgraf minibatcha:
+//   indptr [n+1], indices [E] - CSR w numeracji lokalnej (kwadratowy n x n),
+//   nodes [n]                 - numer globalny węzła lokalnego,
+//   edge_ids [E]              - numer krawędzi w grafie wejściowym,
+//   hop_offsets [hops+2]      - węzły [hop_offsets[h], hop_offsets[h+1]) zostały
+//                               dodane w skoku h (skok 0 to seedy).
+// Seedy mają numery lokalne 0..hop_offsets[1]-1, więc wynik modelu dla
+// batcha to pierwsze hop_offsets[1] wierszy. Wiersze węzłów z ostatniego
+// skoku są puste.
+struct SampledSubgraph
+{
+    std::vector<int64_t> indptr;
+    std::vector<int64_t> indices;
+    std::vector<int64_t> nodes;
+    std::vector<int64_t> edge_ids;
+    std::vector<int64_t> hop_offsets;
+};
+
+// Klasa: NeighborSampler
+// Trzyma wskaźniki do grafu (bez kopiowania) i bufory o rozmiarze liczby
+// węzłów, czyszczone po każdym wywołaniu tylko na użytych węzłach.
+// Jedno wywołanie sample() jest równoległe (OpenMP), ale obiekt nie może
+// być używany z kilku wątków naraz - każdy wątek ładujący ma własny sampler.
+class NeighborSampler
+{
+public:
+    NeighborSampler(const int64_t *indptr, const int64_t *indices, int64_t num_nodes, uint64_t seed)
+        : indptr_(indptr), indices_(indices), seed_(seed),
+          local_id_(num_nodes, -1), first_pos_(num_nodes)
+    {
+        for (auto &p : first_pos_)
+        {
+            p.store(kNone, std::memory_order_relaxed);
+        }
+    }
+
+    // fanouts[h] < 0 oznacza wszystkich sąsiadów w skoku h
+    SampledSubgraph sample(const int64_t *seeds, int64_t num_seeds,
+                           const std::vector<int64_t> &fanouts, uint64_t batch_key)
+    {
+        SampledSubgraph out;
+        out.indptr.push_back(0);
+        out.hop_offsets.push_back(0);
+
+        // skok 0: seedy (powtórzenia są scalane)
+        std::vector<int64_t> seed_list(seeds, seeds + num_seeds);
+        std::vector<int64_t> seed_slot(num_seeds);
+        add_new_nodes(seed_list, seed_slot, out.nodes);
+        out.hop_offsets.push_back(static_cast<int64_t>(out.nodes.size()));
+
+        std::vector<int64_t> counts;
+        std::vector<int64_t> offsets;
+        std::vector<int64_t> sources;
+        std::vector<int64_t> edges;
+        std::vector<int64_t> local;
+
+        for (size_t hop = 0; hop < fanouts.size(); hop++)
+        {
+            int64_t begin = out.hop_offsets[hop];
+            int64_t end = out.hop_offsets[hop + 1];
+            int64_t frontier = end - begin;
+            int64_t fanout = fanouts[hop];
+
+            counts.assign(frontier, 0);
+#pragma omp parallel for schedule(static)
+            for (int64_t i = 0; i < frontier; i++)
+            {
+                int64_t v = out.nodes[begin + i];
+                int64_t degree = indptr_[v + 1] - indptr_[v];
+                counts[i] = fanout < 0 ? degree : std::min(fanout, degree);
+            }
+
+            offsets.assign(frontier + 1, 0);
+            for (int64_t i = 0; i < frontier; i++)
+            {
+                offsets[i + 1] = offsets[i] + counts[i];
+            }
+            int64_t E_hop = offsets[frontier];
+            sources.resize(E_hop);
+            edges.resize(E_hop);
+
+#pragma omp parallel for schedule(dynamic, 64)
+            for (int64_t i = 0; i < frontier; i++)
+            {
+                int64_t v = out.nodes[begin + i];
+                sample_row(v, hop, batch_key, counts[i], edges.data() + offsets[i]);
+                for (int64_t k = offsets[i]; k < offsets[i + 1]; k++)
+                {
+                    sources[k] = indices_[edges[k]];
+                }
+            }
+
+            local.resize(E_hop);
+            add_new_nodes(sources, local, out.nodes);
+
+            int64_t base = out.indptr.back();
+            for (int64_t i = 0; i < frontier; i++)
+            {
+                out.indptr.push_back(base + offsets[i + 1]);
+            }
+            out.indices.insert(out.indices.end(), local.begin(), local.end());
+            out.edge_ids.insert(out.edge_ids.end(), edges.begin(), edges.end());
+            out.hop_offsets.push_back(static_cast<int64_t>(out.nodes.size()));
+        }
+
+        // węzły z ostatniego skoku nie są rozwijane - puste wiersze
+        out.indptr.resize(out.nodes.size() + 1, out.indptr.back());
+
+        // czyszczenie buforów na użytych węzłach
+        int64_t n = static_cast<int64_t>(out.nodes.size());
+#pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < n; i++)
+        {
+            local_id_[out.nodes[i]] = -1;
+        }
+        return out;
+    }
+
+private:
+    static constexpr int64_t kNone = std::numeric_limits<int64_t>::max();
+
+    // Wybiera count różnych krawędzi z wiersza v (algorytm Floyda, bez
+    // powtórzeń) i zapisuje ich numery rosnąco do out.
+    void sample_row(int64_t v, uint64_t hop, uint64_t batch_key, int64_t count, int64_t *out) const
+    {
+        int64_t row_begin = indptr_[v];
+        int64_t degree = indptr_[v + 1] - row_begin;
+        if (count == degree)
+        {
+            for (int64_t k = 0; k < count; k++)
+            {
+                out[k] = row_begin + k;
+            }
+            return;
+        }
+
+        for (int64_t k = 0, j = degree - count; j < degree; j++, k++)
+        {
+            int64_t t = static_cast<int64_t>(sampler_random(seed_, batch_key, hop, v, j) % uint64_t(j + 1));
+            int64_t pick = std::find(out, out + k, t) == out + k ? t : j;
+            out[k] = pick;
+        }
+        std::sort(out, out + count);
+        for (int64_t k = 0; k < count; k++)
+        {
+            out[k] += row_begin;
+        }
+    }
+
+    // Nadaje numery lokalne węzłom globalnym z global, które jeszcze ich nie
+    // mają, w kolejności pierwszego wystąpienia (deterministycznie przy
+    // dowolnej liczbie wątków), i dopisuje je do nodes. local[p] to numer
+    // lokalny global[p].
+    void add_new_nodes(const std::vector<int64_t> &global, std::vector<int64_t> &local, std::vector<int64_t> &nodes)
+    {
+        int64_t E = static_cast<int64_t>(global.size());
+
+        // pierwsze wystąpienie każdego węzła (atomowe minimum pozycji)
+#pragma omp parallel for schedule(static)
+        for (int64_t p = 0; p < E; p++)
+        {
+            int64_t u = global[p];
+            if (local_id_[u] >= 0)
+            {
+                continue;
+            }
+            int64_t current = first_pos_[u].load(std::memory_order_relaxed);
+            while (p < current && !first_pos_[u].compare_exchange_weak(current, p, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // numery lokalne: suma prefiksowa po kawałkach na wątek
+        int64_t base = static_cast<int64_t>(nodes.size());
+        int64_t T = std::max<int64_t>(1, std::min<int64_t>(omp_get_max_threads(), E / 4096));
+        std::vector<int64_t> chunk_new(T + 1, 0);
+        auto chunk_begin = [&](int64_t t) { return E * t / T; };
+        auto is_new = [&](int64_t p) { return first_pos_[global[p]].load(std::memory_order_relaxed) == p; };
+
+#pragma omp parallel for schedule(static, 1)
+        for (int64_t t = 0; t < T; t++)
+        {
+            int64_t count = 0;
+            for (int64_t p = chunk_begin(t); p < chunk_begin(t + 1); p++)
+            {
+                count += is_new(p);
+            }
+            chunk_new[t + 1] = count;
+        }
+        for (int64_t t = 0; t < T; t++)
+        {
+            chunk_new[t + 1] += chunk_new[t];
+        }
+        nodes.resize(base + chunk_new[T]);
+
+#pragma omp parallel for schedule(static, 1)
+        for (int64_t t = 0; t < T; t++)
+        {
+            int64_t next = base + chunk_new[t];
+            for (int64_t p = chunk_begin(t); p < chunk_begin(t + 1); p++)
+            {
+                if (is_new(p))
+                {
+                    local_id_[global[p]] = next;
+                    nodes[next++] = global[p];
+                }
+            }
+        }
+
+#pragma omp parallel for schedule(static)
+        for (int64_t p = 0; p < E; p++)
+        {
+            local[p] = local_id_[global[p]];
+            first_pos_[global[p]].store(kNone, std::memory_order_relaxed);
+        }
+    }
+
+    const int64_t *indptr_;
+    const int64_t *indices_;
+    uint64_t seed_;
+    std::vector<int64_t> local_id_;
+    std::vector<std::atomic<int64_t>> first_pos_;
+};
@@ -0,0 +1,146 @@
+#include "spmm_extension.h"
+#include "sddmm.h"
+
+// Funkcja: sddmm_csr
+// score[e,h] = scale * <q[row(e),h,:], k[col(e),h,:]>  (sddmm.h)
+//
+// indices: [E], indptr: [rows+1], q: [rows,H,D], k: [N,H,D] -> score: [E,H]
+//
+// Backward to dwie agregacje tym samym jądrem co spmm_csr_3d, z gradientem
+// score jako wagami krawędzi:
+//   grad_q[row,h,:] = scale * ∑_e grad[e,h] * k[col(e),h,:]     (CSR)
+//   grad_k[c,h,:]   = scale * ∑_{e: col(e)=c} grad[e,h] * q[row(e),h,:]   (CSC)
+// Wejścia fp32.
+
+static torch::Tensor sddmm_forward(torch::Tensor indices, torch::Tensor indptr, torch::Tensor q, torch::Tensor k,
+                                   double scale, const CsrPartition &part)
+{
+    int64_t num_rows = indptr.size(0) - 1;
+    int64_t E = indices.size(0);
+    int64_t H = q.size(1);
+    int64_t D = q.size(2);
+
+    SPMM_OP_SCOPE(op, "sddmm_csr_forward", indices, indptr, q, k);
+    op.work(E, 8 * (num_rows + 1 + E) + 4 * (num_rows * H * D + E * H * D + E * H));
+
+    auto score = torch::empty({E, H}, q.options());
+    op.alloc(score.nbytes());
+    SddmmInput in{indices.data_ptr<int64_t>(), q.data_ptr<float>(), k.data_ptr<float>(), H, D, static_cast<float>(scale)};
+    sddmm_csr_partitioned(part, indptr.data_ptr<int64_t>(), in, score.data_ptr<float>());
+    return score;
+}
+
+class SddmmCsrFunction : public torch::autograd::Function<SddmmCsrFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor q,
+        torch::Tensor k,
+        double scale,
+        std::shared_ptr<CsrPartition> partition,
+        std::shared_ptr<CSRGraph> graph)
+    {
+        TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+        TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+        TORCH_CHECK(q.dim() == 3 && k.dim() == 3, "q and k must be 3D [N,H,D]");
+        TORCH_CHECK(q.size(0) == indptr.size(0) - 1, "q must have num_rows rows");
+        TORCH_CHECK(q.size(1) == k.size(1) && q.size(2) == k.size(2), "q and k must have the same H and D");
+        TORCH_CHECK(q.scalar_type() == torch::kFloat32 && k.scalar_type() == torch::kFloat32, "q and k must be float32");
+
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        q = q.contiguous();
+        k = k.contiguous();
+
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+        TORCH_CHECK(part.num_rows == indptr.size(0) - 1 && part.nnz == indices.size(0),
+                    "partition was built for a different graph");
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        if (graph)
+        {
+            t_indptr = graph->t_indptr;
+            t_rows = graph->t_rows;
+            t_perm = graph->t_perm;
+            ctx->saved_data["row_start_t"] = graph->partition_t.row_start;
+            ctx->saved_data["edge_start_t"] = graph->partition_t.edge_start;
+        }
+
+        ctx->save_for_backward({indices, indptr, q, k, t_indptr, t_rows, t_perm});
+        ctx->saved_data["scale"] = scale;
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+        return sddmm_forward(indices, indptr, q, k, scale, part);
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto q = saved[2];
+        auto k = saved[3];
+        double scale = ctx->saved_data["scale"].toDouble();
+        auto grad_score = (grad_outputs[0].to(torch::kFloat32) * scale).contiguous();
+
+        torch::Tensor grad_q, grad_k;
+
+        if (ctx->needs_input_grad(2))
+        {
+            CsrPartition part;
+            part.num_rows = indptr.size(0) - 1;
+            part.nnz = indices.size(0);
+            part.row_start = ctx->saved_data["row_start"].toIntVector();
+            part.edge_start = ctx->saved_data["edge_start"].toIntVector();
+            grad_q = spmm_csr_3d_forward(indices, indptr, grad_score, k, part);
+        }
+
+        if (ctx->needs_input_grad(3))
+        {
+            if (saved[4].defined())
+            {
+                CsrPartition part_t;
+                part_t.num_rows = saved[4].size(0) - 1;
+                part_t.nnz = indices.size(0);
+                part_t.row_start = ctx->saved_data["row_start_t"].toIntVector();
+                part_t.edge_start = ctx->saved_data["edge_start_t"].toIntVector();
+                grad_k = spmm_csr_3d_backward_dense(saved[4], saved[5], saved[6], grad_score, q, part_t);
+            }
+            else
+            {
+                auto t = csr_transpose(indices, indptr, k.size(0));
+                grad_k = spmm_csr_3d_backward_dense(t[0], t[1], t[2], grad_score, q, make_partition(t[0], 0));
+            }
+        }
+
+        return {torch::Tensor(), torch::Tensor(), grad_q, grad_k, torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    }
+};
+
+torch::Tensor sddmm_csr(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor q,
+    torch::Tensor k,
+    double scale,
+    std::shared_ptr<CsrPartition> partition)
+{
+    return SddmmCsrFunction::apply(indices, indptr, q, k, scale, partition, std::shared_ptr<CSRGraph>());
+}
+
+torch::Tensor sddmm_csr_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor q,
+    torch::Tensor k,
+    double scale)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(k.dim() == 3 && k.size(0) == graph->num_cols, "k must be 3D [num_cols,H,D]");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SddmmCsrFunction::apply(graph->indices, graph->indptr, q, k, scale, partition, graph);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "spmm_kernels.h"
+#include <omp.h>
+#include <cstdint>
+
+// SDDMM (sampled dense-dense matmul) na wzorcu CSR:
+//
+//   score[e,h] = scale * <q[row(e),h,:], k[col(e),h,:]>
+//
+// q: [rows,H,D], k: [N,H,D], score: [E,H]. Iloczyny liczone są wprost do
+// [E,H] w przejściu po indptr/indices - bez zbierania dwóch tensorów [E,H,D]
+// (q[row], k[col]) jak w PyTorch. Wiersz q jest czytany raz na fragment
+// wiersza i zostaje w cache dla wszystkich jego krawędzi.
+// Krawędzie są niezależne (każda zapisuje swoje score[e,:]), więc podział
+// merge-path nie potrzebuje carry.
+
+struct SddmmInput
+{
+    const int64_t *indices;
+    const float *q;
+    const float *k;
+    int64_t H;
+    int64_t D;
+    float scale;
+};
+
+using SddmmSegmentFn = void (*)(const SddmmInput &, int64_t, int64_t, int64_t, float *);
+
+// Funkcja: sddmm_row_segment
+// score[i,:] dla krawędzi i w [begin, end) wiersza row.
+inline void sddmm_row_segment(const SddmmInput &in, int64_t row, int64_t begin, int64_t end, float *score)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+    const float *q_row = in.q + row * H * D;
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        const float *k_row = in.k + in.indices[i] * H * D;
+        for (int64_t h = 0; h < H; h++)
+        {
+            const float *qh = q_row + h * D;
+            const float *kh = k_row + h * D;
+            float acc = 0.0f;
+#pragma omp simd reduction(+ : acc)
+            for (int64_t d = 0; d < D; d++)
+            {
+                acc += qh[d] * kh[d];
+            }
+            score[i * H + h] = in.scale * acc;
+        }
+    }
+}
+
+#ifdef SPMM_X86_TARGETS
+
+// Wersje AVX2/AVX-512 (FMA) dla dowolnego D: pełne wektory 8/16 wartości,
+// resztę D dolicza pętla skalarna.
+__attribute__((target("avx2,fma"))) inline float hsum8_ps(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2,fma"))) inline void sddmm_row_segment_avx2(
+    const SddmmInput &in, int64_t row, int64_t begin, int64_t end, float *score)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+    const int64_t D8 = D & ~int64_t(7);
+    const float *q_row = in.q + row * H * D;
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        const float *k_row = in.k + in.indices[i] * H * D;
+        for (int64_t h = 0; h < H; h++)
+        {
+            const float *qh = q_row + h * D;
+            const float *kh = k_row + h * D;
+            __m256 acc = _mm256_setzero_ps();
+            for (int64_t d = 0; d < D8; d += 8)
+            {
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(qh + d), _mm256_loadu_ps(kh + d), acc);
+            }
+            float s = hsum8_ps(acc);
+            for (int64_t d = D8; d < D; d++)
+            {
+                s += qh[d] * kh[d];
+            }
+            score[i * H + h] = in.scale * s;
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) inline void sddmm_row_segment_avx512(
+    const SddmmInput &in, int64_t row, int64_t begin, int64_t end, float *score)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+    const int64_t D16 = D & ~int64_t(15);
+    const __mmask16 tail = static_cast<__mmask16>((1u << (D - D16)) - 1u);
+    const float *q_row = in.q + row * H * D;
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        const float *k_row = in.k + in.indices[i] * H * D;
+        for (int64_t h = 0; h < H; h++)
+        {
+            const float *qh = q_row + h * D;
+            const float *kh = k_row + h * D;
+            __m512 acc = _mm512_setzero_ps();
+            for (int64_t d = 0; d < D16; d += 16)
+            {
+                acc = _mm512_fmadd_ps(_mm512_loadu_ps(qh + d), _mm512_loadu_ps(kh + d), acc);
+            }
+            if (tail)
+            {
+                acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, qh + D16), _mm512_maskz_loadu_ps(tail, kh + D16), acc);
+            }
+            score[i * H + h] = in.scale * _mm512_reduce_add_ps(acc);
+        }
+    }
+}
+
+#endif // SPMM_X86_TARGETS
+
+// Jądro fragmentu wiersza dla CPU: AVX-512 od D >= 16, AVX2 od D >= 8
+// (te same testy CPU co select_row_segment).
+inline SddmmSegmentFn select_sddmm_segment(int64_t D)
+{
+#ifdef SPMM_X86_TARGETS
+    if (D >= 16 && cpu_has_avx512f())
+    {
+        return &sddmm_row_segment_avx512;
+    }
+    if (D >= 8 && cpu_has_avx2_fma())
+    {
+        return &sddmm_row_segment_avx2;
+    }
+#endif
+    return &sddmm_row_segment;
+}
+
+// Funkcja: sddmm_csr_partitioned
+// score [E,H] dla wszystkich krawędzi, części merge-path równolegle.
+inline void sddmm_csr_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const SddmmInput &in,
+    float *score)
+{
+    SddmmSegmentFn segment = select_sddmm_segment(in.D);
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < part.num_parts(); p++)
+    {
+        spmm_stats::BusyScope busy(op);
+        part.for_each_segment(p, indptr, [&](int64_t, int64_t row, int64_t begin, int64_t end, bool)
+        {
+            segment(in, row, begin, end, score);
+        });
+    }
+}
@@ -1,12 +1,19 @@
+import os
 from setuptools import setup
 from torch.utils.cpp_extension import CppExtension, BuildExtension
 
+# Instrumentacja (instrumentation.h), domyślnie wyłączona:
+#   SPMM_STATS=1 python setup.py install           - spmm_extension.stats()
+#   SPMM_RECORD_FUNCTION=1 python setup.py install - operacje w torch.profiler
+define_macros = [(name, os.environ.get(name, '0')) for name in ('SPMM_STATS', 'SPMM_RECORD_FUNCTION')]
+
 setup(
     name='spmm_extension',
     ext_modules=[
         CppExtension(
             name='spmm_extension',
-            sources=['spmm_extension.cpp'],
+            sources=['spmm_extension.cpp', 'gat_fused.cpp', 'layouts.cpp', 'coo_csr.cpp', 'csr_graph.cpp', 'reorder.cpp', 'sampler.cpp', 'quantized.cpp', 'instrumentation.cpp', 'reductions.cpp', 'anisotropic.cpp', 'sddmm.cpp', 'gat_project.cpp'],
+            define_macros=define_macros,
             extra_compile_args=['-fopenmp'],  # flaga dla OpenMP
         )
     ],
@@ -1,4 +1,5 @@
-#include <torch/extension.h>
+#include "spmm_extension.h"
+#include "coo_csr.h"
 #include <omp.h>
 
 // Funkcja: spmm_csr_3d
@@ -10,14 +11,35 @@
 //
 // Wynik: [N,H,D]
 //
+// data i dense_matrix mogą być przechowywane w float32, float16 albo bfloat16
+// (oba w tym samym typie). Jądro czyta wartości 16-bitowe, rozszerza je do
+// fp32 w rejestrach (spmm_kernels.h) i akumuluje w fp32. Typ wyniku wybiera
+// out_dtype; domyślnie jest to typ dense_matrix.
+//
 // Dla każdego wiersza (row), heada (h) i cechy (d):
 // result[row,h,d] = ∑_{edge w wierszu row} data[edge,h] * dense_matrix[col(edge),h,d]
 
-torch::Tensor spmm_csr_3d(
+// Podział jest wykonywany metodą merge-path (csr_partition.h): każdy wątek
+// dostaje tyle samo (wierszy + krawędzi), a wiersz jest zapisywany przez
+// dokładnie jedną część, więc wynik nie zależy od przeplotu wątków.
+
+CsrPartition make_partition(torch::Tensor indptr, int64_t num_parts)
+{
+    TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+    indptr = indptr.contiguous();
+    if (num_parts <= 0)
+    {
+        num_parts = omp_get_max_threads();
+    }
+    return CsrPartition::build(indptr.data_ptr<int64_t>(), indptr.size(0) - 1, num_parts);
+}
+
+torch::Tensor spmm_csr_3d_forward(
     torch::Tensor indices,
     torch::Tensor indptr,
     torch::Tensor data,
-    torch::Tensor dense_matrix)
+    torch::Tensor dense_matrix,
+    const CsrPartition &part)
 {
     TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
     TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
@@ -25,49 +47,498 @@ torch::Tensor spmm_csr_3d(
     TORCH_CHECK(dense_matrix.dim() == 3, "dense_matrix must be 3D [N,H,D]");
 
     int64_t num_rows = indptr.size(0) - 1;
-    int64_t E = indices.size(0);
     int64_t H = data.size(1);
-    int64_t N = dense_matrix.size(0);
     TORCH_CHECK(dense_matrix.size(1) == H, "dense_matrix second dim must match H");
     int64_t D = dense_matrix.size(2);
+    TORCH_CHECK(part.num_rows == num_rows && part.nnz == indices.size(0),
+                "partition was built for a different graph");
+    TORCH_CHECK(data.scalar_type() == dense_matrix.scalar_type(),
+                "data and dense_matrix must have the same dtype");
 
-    auto result = torch::zeros({num_rows, H, D}, data.options());
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_forward", indices, indptr, data, dense_matrix);
+    op.work(indices.size(0), spmm_stats::spmm_bytes(num_rows, indices.size(0), H, D, dense_matrix.element_size()));
 
-    auto indices_ptr = indices.data_ptr<int64_t>();
-    auto indptr_ptr = indptr.data_ptr<int64_t>();
-    auto data_ptr = data.data_ptr<float>();
-    auto dense_ptr = dense_matrix.data_ptr<float>();
-    auto result_ptr = result.data_ptr<float>();
+    // każdy wiersz jest nadpisywany przez jądro, więc zerowanie nie jest potrzebne;
+    // wynik jest w typie akumulatora (fp32)
+    auto result = torch::empty({num_rows, H, D}, data.options().dtype(torch::kFloat32));
+    op.alloc(result.nbytes());
 
     // indeksowanie:
     // result[row,h,d] = result_ptr[row*H*D + h*D + d]
     // dense_matrix[col,h,d] = dense_ptr[col*H*D + h*D + d]
 
-#pragma omp parallel for collapse(2)
-    for (int64_t row = 0; row < num_rows; row++)
+    auto run = [&](auto *data_ptr, auto *dense_ptr)
+    {
+        spmm_csr_3d_partitioned(
+            part,
+            indices.data_ptr<int64_t>(),
+            indptr.data_ptr<int64_t>(),
+            data_ptr,
+            dense_ptr,
+            H, D,
+            result.data_ptr<float>());
+    };
+
+    switch (dense_matrix.scalar_type())
+    {
+    case torch::kFloat32:
+        run(data.data_ptr<float>(), dense_matrix.data_ptr<float>());
+        break;
+    case torch::kFloat16:
+        run(reinterpret_cast<const Fp16 *>(data.data_ptr<at::Half>()),
+            reinterpret_cast<const Fp16 *>(dense_matrix.data_ptr<at::Half>()));
+        break;
+    case torch::kBFloat16:
+        run(reinterpret_cast<const Bf16 *>(data.data_ptr<at::BFloat16>()),
+            reinterpret_cast<const Bf16 *>(dense_matrix.data_ptr<at::BFloat16>()));
+        break;
+    default:
+        TORCH_CHECK(false, "spmm_csr_3d supports float32, float16 and bfloat16 inputs");
+    }
+
+    return result;
+}
+
+// Funkcja: csr_transpose
+// Buduje transpozycję (CSC) wzorca CSR sortowaniem przez zliczanie.
+// Zwraca (t_indptr [num_cols+1], t_rows [E], t_perm [E]), gdzie dla kolumny c
+// krawędzie t_perm[t_indptr[c] .. t_indptr[c+1]) to oryginalne numery krawędzi,
+// a t_rows - ich wiersze. Sortowanie jest stabilne (stable_counting_sort),
+// więc kolejność jest deterministyczna (rosnąco po wierszu).
+
+std::vector<torch::Tensor> csr_transpose(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    int64_t num_cols)
+{
+    TORCH_CHECK(indices.dim() == 1, "indices must be 1D");
+    TORCH_CHECK(indptr.dim() == 1, "indptr must be 1D");
+
+    indices = indices.contiguous();
+    indptr = indptr.contiguous();
+    int64_t num_rows = indptr.size(0) - 1;
+    int64_t E = indices.size(0);
+
+    SPMM_OP_SCOPE(op, "csr_transpose", indices, indptr);
+    op.work(E, 8 * (num_rows + 1 + num_cols + 1 + 4 * E));
+
+    auto t_indptr = torch::empty({num_cols + 1}, indptr.options());
+    auto t_rows = torch::empty({E}, indices.options());
+    auto t_perm = torch::empty({E}, indices.options());
+    auto t_rows_ptr = t_rows.data_ptr<int64_t>();
+    auto t_perm_ptr = t_perm.data_ptr<int64_t>();
+
+    std::vector<int64_t> row_of(E);
+    op.alloc(t_indptr.nbytes() + t_rows.nbytes() + t_perm.nbytes() + E * int64_t(sizeof(int64_t)));
+    csr_row_of_edge(indptr.data_ptr<int64_t>(), num_rows, row_of.data());
+    stable_counting_sort(indices.data_ptr<int64_t>(), nullptr, E, num_cols, t_indptr.data_ptr<int64_t>(), t_perm_ptr);
+
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < E; i++)
     {
-        for (int64_t i = indptr_ptr[row]; i < indptr_ptr[row + 1]; i++)
+        t_rows_ptr[i] = row_of[t_perm_ptr[i]];
+    }
+
+    return {t_indptr, t_rows, t_perm};
+}
+
+// Funkcja: spmm_csr_3d_backward_data
+// grad_data[e,h] = <grad_out[row(e),h,:], dense_matrix[col(e),h,:]>
+// Każda krawędź należy do dokładnie jednej części podziału, więc zapisy
+// są rozłączne także wtedy, gdy wiersz-hub jest dzielony między wątki.
+
+torch::Tensor spmm_csr_3d_backward_data(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor grad_out,
+    torch::Tensor dense_matrix,
+    const CsrPartition &part)
+{
+    int64_t E = indices.size(0);
+    int64_t H = dense_matrix.size(1);
+    int64_t D = dense_matrix.size(2);
+
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_backward_data", indices, indptr, grad_out, dense_matrix);
+    op.work(E, 8 * (indptr.size(0) + E) + 4 * (2 * E * H * D + E * H));
+
+    auto grad_data = torch::empty({E, H}, dense_matrix.options());
+    op.alloc(grad_data.nbytes());
+
+    auto indices_ptr = indices.data_ptr<int64_t>();
+    auto indptr_ptr = indptr.data_ptr<int64_t>();
+    auto grad_out_ptr = grad_out.data_ptr<float>();
+    auto dense_ptr = dense_matrix.data_ptr<float>();
+    auto grad_data_ptr = grad_data.data_ptr<float>();
+
+    spmm_stats::OpScope *busy_op = spmm_stats::OpScope::current();
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < part.num_parts(); p++)
+    {
+        spmm_stats::BusyScope busy(busy_op);
+        part.for_each_segment(p, indptr_ptr, [&](int64_t, int64_t row, int64_t begin, int64_t end, bool)
         {
-            int64_t col = indices_ptr[i];
-            const float *in_row = dense_ptr + col * H * D;
+            const float *g_row = grad_out_ptr + row * H * D;
 
-            for (int64_t h = 0; h < H; h++)
+            for (int64_t i = begin; i < end; i++)
             {
-                float edge_weight = data_ptr[i * H + h]; // data[i,h]
-                float *out_row = result_ptr + row * H * D + h * D;
+                const float *in_row = dense_ptr + indices_ptr[i] * H * D;
 
-                for (int64_t d = 0; d < D; d++)
+                for (int64_t h = 0; h < H; h++)
                 {
-                    out_row[d] += edge_weight * in_row[h * D + d];
+                    float acc = 0.0f;
+                    for (int64_t d = 0; d < D; d++)
+                    {
+                        acc += g_row[h * D + d] * in_row[h * D + d];
+                    }
+                    grad_data_ptr[i * H + h] = acc;
                 }
             }
+        });
+    }
+
+    return grad_data;
+}
+
+// Funkcja: spmm_csr_3d_backward_dense
+// grad_dense[c,h,d] = ∑_{edge: col(edge) == c} data[edge,h] * grad_out[row(edge),h,d]
+// To zwykłe spmm_csr_3d po transpozycji (CSC) z wagami przestawionymi do
+// kolejności CSC, więc korzysta z tego samego jądra i podziału merge-path
+// i nie tworzy pośredniego tensora [E,H,D].
+
+torch::Tensor spmm_csr_3d_backward_dense(
+    torch::Tensor t_indptr,
+    torch::Tensor t_rows,
+    torch::Tensor t_perm,
+    torch::Tensor data,
+    torch::Tensor grad_out,
+    const CsrPartition &part_t)
+{
+    SPMM_OP_SCOPE(op, "spmm_csr_3d_backward_dense", t_indptr, t_rows, data, grad_out);
+    auto data_t = data.index_select(0, t_perm).contiguous(); // [E,H] w kolejności CSC
+    op.alloc(data_t.nbytes());
+    return spmm_csr_3d_forward(t_rows, t_indptr, data_t, grad_out, part_t);
+}
+
+// Autograd dla spmm_csr_3d - forward jak wyżej, backward liczy
+// grad_data (iloczyny skalarne po krawędziach) i grad_dense (transponowana agregacja).
+// Dla wejść fp16/bf16 backward liczy w fp32, a gradienty wracają w typach wejść.
+// Granice podziału zapisujemy w kontekście, żeby backward użył tego samego podziału.
+// Gdy podany jest CSRGraph, backward bierze z niego gotową transpozycję
+// i jej podział zamiast liczyć je od nowa.
+class SpmmCsr3dFunction : public torch::autograd::Function<SpmmCsr3dFunction>
+{
+public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext *ctx,
+        torch::Tensor indices,
+        torch::Tensor indptr,
+        torch::Tensor data,
+        torch::Tensor dense_matrix,
+        std::shared_ptr<CsrPartition> partition,
+        std::shared_ptr<CSRGraph> graph,
+        c10::optional<at::ScalarType> out_dtype)
+    {
+        indices = indices.contiguous();
+        indptr = indptr.contiguous();
+        data = data.contiguous();
+        dense_matrix = dense_matrix.contiguous();
+
+        CsrPartition part = partition ? *partition : make_partition(indptr, 0);
+
+        torch::Tensor t_indptr, t_rows, t_perm;
+        if (graph)
+        {
+            t_indptr = graph->t_indptr;
+            t_rows = graph->t_rows;
+            t_perm = graph->t_perm;
+            ctx->saved_data["row_start_t"] = graph->partition_t.row_start;
+            ctx->saved_data["edge_start_t"] = graph->partition_t.edge_start;
+        }
+
+        ctx->save_for_backward({indices, indptr, data, dense_matrix, t_indptr, t_rows, t_perm});
+        ctx->saved_data["row_start"] = part.row_start;
+        ctx->saved_data["edge_start"] = part.edge_start;
+
+        auto result = spmm_csr_3d_forward(indices, indptr, data, dense_matrix, part);
+        auto dtype = out_dtype.value_or(dense_matrix.scalar_type());
+        TORCH_CHECK(at::isFloatingType(dtype), "out_dtype must be a floating point type");
+        return dtype == torch::kFloat32 ? result : result.to(dtype);
+    }
+
+    static torch::autograd::tensor_list backward(
+        torch::autograd::AutogradContext *ctx,
+        torch::autograd::tensor_list grad_outputs)
+    {
+        auto saved = ctx->get_saved_variables();
+        auto indices = saved[0];
+        auto indptr = saved[1];
+        auto data = saved[2].to(torch::kFloat32);
+        auto dense_matrix = saved[3].to(torch::kFloat32);
+        auto grad_out = grad_outputs[0].to(torch::kFloat32).contiguous();
+
+        CsrPartition part;
+        part.num_rows = indptr.size(0) - 1;
+        part.nnz = indices.size(0);
+        part.row_start = ctx->saved_data["row_start"].toIntVector();
+        part.edge_start = ctx->saved_data["edge_start"].toIntVector();
+
+        torch::Tensor grad_data, grad_dense;
+
+        if (ctx->needs_input_grad(2))
+        {
+            grad_data = spmm_csr_3d_backward_data(indices, indptr, grad_out, dense_matrix, part)
+                            .to(saved[2].scalar_type());
+        }
+
+        if (ctx->needs_input_grad(3))
+        {
+            if (saved[4].defined())
+            {
+                CsrPartition part_t;
+                part_t.num_rows = saved[4].size(0) - 1;
+                part_t.nnz = indices.size(0);
+                part_t.row_start = ctx->saved_data["row_start_t"].toIntVector();
+                part_t.edge_start = ctx->saved_data["edge_start_t"].toIntVector();
+                grad_dense = spmm_csr_3d_backward_dense(saved[4], saved[5], saved[6], data, grad_out, part_t);
+            }
+            else
+            {
+                auto t = csr_transpose(indices, indptr, dense_matrix.size(0));
+                grad_dense = spmm_csr_3d_backward_dense(t[0], t[1], t[2], data, grad_out, make_partition(t[0], 0));
+            }
+            grad_dense = grad_dense.to(saved[3].scalar_type());
         }
+
+        return {torch::Tensor(), torch::Tensor(), grad_data, grad_dense, torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    }
+};
+
+torch::Tensor spmm_csr_3d(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor dense_matrix,
+    std::shared_ptr<CsrPartition> partition,
+    c10::optional<at::ScalarType> out_dtype)
+{
+    return SpmmCsr3dFunction::apply(indices, indptr, data, dense_matrix, partition, std::shared_ptr<CSRGraph>(), out_dtype);
+}
+
+torch::Tensor spmm_csr_3d_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    torch::Tensor dense_matrix,
+    c10::optional<at::ScalarType> out_dtype)
+{
+    TORCH_CHECK(graph, "graph must not be None");
+    TORCH_CHECK(dense_matrix.dim() == 3 && dense_matrix.size(0) == graph->num_cols,
+                "dense_matrix must be 3D [num_cols,H,D]");
+    auto partition = std::make_shared<CsrPartition>(graph->partition);
+    return SpmmCsr3dFunction::apply(graph->indices, graph->indptr, data, dense_matrix, partition, graph, out_dtype);
+}
+
+// dtype z Pythona (np. torch.float16) albo None
+static c10::optional<at::ScalarType> dtype_arg(const py::object &dtype)
+{
+    if (dtype.is_none())
+    {
+        return c10::nullopt;
     }
+    return torch::python::detail::py_object_to_dtype(dtype);
+}
 
+// Wynik spmm_csr_3d_reduce dla jednej redukcji: tensor dla sum/mean,
+// (wartości, arg) dla max/min - jak torch.sum i torch.max(x, dim).
+static py::object single_reduce_result(const std::vector<torch::Tensor> &out)
+{
+    if (out.size() == 2)
+    {
+        return py::make_tuple(out[0], out[1]);
+    }
+    return py::cast(out[0]);
+}
+
+// Wynik spmm_csr_3d_multi: {nazwa redukcji: wartości, "argmax"/"argmin": numery krawędzi}.
+static py::dict multi_reduce_result(const std::vector<std::string> &reduces, const std::vector<torch::Tensor> &out)
+{
+    py::dict result;
+    size_t next_arg = reduces.size();
+    for (size_t k = 0; k < reduces.size(); k++)
+    {
+        result[py::str(reduces[k])] = out[k];
+        if (reduces[k] == "max" || reduces[k] == "min")
+        {
+            result[py::str("arg" + reduces[k])] = out[next_arg++];
+        }
+    }
     return result;
 }
 
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
 {
-    m.def("spmm_csr_3d", &spmm_csr_3d, "CSR x Dense (3D) SpMM");
+    py::class_<CsrPartition, std::shared_ptr<CsrPartition>>(m, "CsrPartition")
+        .def(py::init([](torch::Tensor indptr, int64_t num_parts)
+                      { return std::make_shared<CsrPartition>(make_partition(indptr, num_parts)); }),
+             py::arg("indptr"), py::arg("num_parts") = 0)
+        .def_property_readonly("num_parts", &CsrPartition::num_parts)
+        .def_readonly("num_rows", &CsrPartition::num_rows)
+        .def_readonly("nnz", &CsrPartition::nnz)
+        .def_readonly("row_start", &CsrPartition::row_start)
+        .def_readonly("edge_start", &CsrPartition::edge_start);
+
+    py::class_<CSRGraph, std::shared_ptr<CSRGraph>>(m, "CSRGraph")
+        .def(py::init(&CSRGraph::build),
+             py::arg("indptr"), py::arg("indices"), py::arg("num_cols") = -1, py::arg("num_parts") = 0,
+             py::arg("perm") = py::none())
+        .def_readonly("num_rows", &CSRGraph::num_rows)
+        .def_readonly("num_cols", &CSRGraph::num_cols)
+        .def_readonly("nnz", &CSRGraph::nnz)
+        .def_readonly("indptr", &CSRGraph::indptr)
+        .def_readonly("indices", &CSRGraph::indices)
+        .def_readonly("t_indptr", &CSRGraph::t_indptr)
+        .def_readonly("t_rows", &CSRGraph::t_rows)
+        .def_readonly("t_perm", &CSRGraph::t_perm)
+        .def_property_readonly("partition", [](const CSRGraph &g) { return std::make_shared<CsrPartition>(g.partition); })
+        .def_readonly("out_degree", &CSRGraph::out_degree)
+        .def_readonly("in_degree", &CSRGraph::in_degree)
+        .def_readonly("max_out_degree", &CSRGraph::max_out_degree)
+        .def_readonly("max_in_degree", &CSRGraph::max_in_degree)
+        .def_readonly("mean_degree", &CSRGraph::mean_degree)
+        .def_property_readonly("perm", [](const CSRGraph &g) -> py::object
+                               { return g.perm.defined() ? py::cast(g.perm) : py::none(); })
+        .def_property_readonly("inv_perm", [](const CSRGraph &g) -> py::object
+                               { return g.inv_perm.defined() ? py::cast(g.inv_perm) : py::none(); })
+        .def_property_readonly("edge_perm", [](const CSRGraph &g) -> py::object
+                               { return g.edge_perm.defined() ? py::cast(g.edge_perm) : py::none(); });
+
+    py::class_<CsrNeighborSampler, std::shared_ptr<CsrNeighborSampler>>(m, "NeighborSampler")
+        .def(py::init<torch::Tensor, torch::Tensor, int64_t>(),
+             "Próbkowanie sąsiadów (fanout na skok) z grafu CSR: wiersz - węzeł docelowy, indices - źródła",
+             py::arg("indptr"), py::arg("indices"), py::arg("seed") = 0)
+        .def("sample", &CsrNeighborSampler::sample,
+             "Lokalny podgraf minibatcha: [indptr, indices, nodes, edge_ids, hop_offsets]",
+             py::arg("seeds"), py::arg("fanouts"), py::arg("batch_key") = 0)
+        .def_readonly("num_nodes", &CsrNeighborSampler::num_nodes);
+
+    m.attr("STATS_ENABLED") = py::bool_(SPMM_STATS);
+    m.attr("RECORD_FUNCTION_ENABLED") = py::bool_(SPMM_RECORD_FUNCTION);
+    m.def("stats", &stats,
+          "Liczniki operacji (SPMM_STATS): calls, time_ms, edges, bytes, alloc_bytes, thread_busy_ms, imbalance",
+          py::arg("reset") = false);
+
+    m.def("spmm_csr_3d",
+          [](std::shared_ptr<CSRGraph> graph, torch::Tensor data, torch::Tensor dense_matrix, py::object out_dtype)
+          { return spmm_csr_3d_graph(graph, data, dense_matrix, dtype_arg(out_dtype)); },
+          "CSR x Dense (3D) SpMM dla CSRGraph (z autograd); wejścia fp32/fp16/bf16, akumulacja fp32",
+          py::arg("graph"), py::arg("data"), py::arg("dense_matrix"), py::arg("out_dtype") = py::none());
+    m.def("spmm_csr_3d",
+          [](torch::Tensor indices, torch::Tensor indptr, torch::Tensor data, torch::Tensor dense_matrix,
+             std::shared_ptr<CsrPartition> partition, py::object out_dtype)
+          { return spmm_csr_3d(indices, indptr, data, dense_matrix, partition, dtype_arg(out_dtype)); },
+          "CSR x Dense (3D) SpMM (z autograd); wejścia fp32/fp16/bf16, akumulacja fp32",
+          py::arg("indices"), py::arg("indptr"), py::arg("data"), py::arg("dense_matrix"),
+          py::arg("partition") = nullptr, py::arg("out_dtype") = py::none());
+    py::class_<QuantizedFeatures, std::shared_ptr<QuantizedFeatures>>(m, "QuantizedFeatures")
+        .def(py::init(&QuantizedFeatures::build),
+             "Kwantyzacja int8 cech [N,H,D] lub [N,F] (skala i punkt zera na wiersz albo na wiersz i head)",
+             py::arg("x"), py::arg("per_head") = false)
+        .def("dequantize", &QuantizedFeatures::dequantize, "scale * (q - zero_point) jako float32")
+        .def_property_readonly("nbytes", &QuantizedFeatures::nbytes)
+        .def_readonly("q", &QuantizedFeatures::q)
+        .def_readonly("scale", &QuantizedFeatures::scale)
+        .def_readonly("zero_point", &QuantizedFeatures::zero_point)
+        .def_readonly("per_head", &QuantizedFeatures::per_head);
+
+    m.def("spmm_csr_3d_int8", &spmm_csr_3d_int8_graph,
+          "CSR x int8 (3D) SpMM dla CSRGraph z dekwantyzacją w pętli gather (bez autograd)",
+          py::arg("graph"), py::arg("data"), py::arg("features"));
+    m.def("spmm_csr_3d_int8", &spmm_csr_3d_int8,
+          "CSR x int8 (3D) SpMM z dekwantyzacją w pętli gather (bez autograd)",
+          py::arg("indices"), py::arg("indptr"), py::arg("data"), py::arg("features"),
+          py::arg("partition") = nullptr);
+    m.def("csr_transpose", &csr_transpose, "Transpozycja CSR -> CSC (t_indptr, t_rows, t_perm)");
+    m.def("coo_to_csr", &coo_to_csr,
+          "COO -> CSR (indptr, indices, values, perm, t_indptr, t_rows, t_perm) równoległym sortowaniem przez zliczanie",
+          py::arg("row"), py::arg("col"), py::arg("values") = py::none(), py::arg("num_nodes"),
+          py::arg("with_csc") = false, py::arg("merge_duplicates") = false,
+          py::arg("add_self_loops") = false, py::arg("self_loop_value") = 1.0);
+    m.def("reorder_permutation", &reorder_permutation,
+          "Permutacja wierzchołków perm[new] = old (rcm/degree/community/none)",
+          py::arg("indptr"), py::arg("indices"), py::arg("method") = "rcm", py::arg("max_iterations") = 10);
+    m.def("permute_csr", &permute_csr, "Przenumerowanie CSR wg perm (new_indptr, new_indices, edge_perm)",
+          py::arg("indptr"), py::arg("indices"), py::arg("perm"));
+    m.def("reorder_graph", &reorder_graph, "Przenumerowany CSRGraph z ustawionym perm/inv_perm/edge_perm",
+          py::arg("indptr"), py::arg("indices"), py::arg("method") = "rcm", py::arg("num_parts") = 0,
+          py::arg("max_iterations") = 10);
+    m.def("permute_nodes", &permute_nodes, "x[perm]: oryginalna numeracja -> numeracja grafu",
+          py::arg("graph"), py::arg("x"));
+    m.def("unpermute_nodes", &unpermute_nodes, "y[inv_perm]: numeracja grafu -> oryginalna numeracja",
+          py::arg("graph"), py::arg("y"));
+    m.def("locality_report", &locality_report, "Miary lokalności: bandwidth, mean_distance, mean_gap",
+          py::arg("indptr"), py::arg("indices"));
+    m.def("to_layout", &to_layout, "Konwersja [N,H,D] -> układ nhd/hnd/tiled",
+          py::arg("x"), py::arg("layout"), py::arg("block") = 16);
+    m.def("from_layout", &from_layout, "Konwersja układu nhd/hnd/tiled -> [N,H,D]",
+          py::arg("x"), py::arg("layout"), py::arg("num_nodes"));
+    m.def("spmm_csr_3d_layout", &spmm_csr_3d_layout_graph, "CSR x Dense (3D) SpMM w układzie nhd/hnd/tiled dla CSRGraph (z autograd)",
+          py::arg("graph"), py::arg("data"), py::arg("x"), py::arg("layout"), py::arg("head_block") = 0);
+    m.def("spmm_csr_3d_layout", &spmm_csr_3d_layout, "CSR x Dense (3D) SpMM w układzie nhd/hnd/tiled (z autograd)",
+          py::arg("indices"), py::arg("indptr"), py::arg("data"), py::arg("x"), py::arg("layout"),
+          py::arg("partition") = nullptr, py::arg("head_block") = 0);
+    m.def("spmm_csr_3d_reduce",
+          [](std::shared_ptr<CSRGraph> graph, c10::optional<torch::Tensor> data, torch::Tensor x, const std::string &reduce)
+          { return single_reduce_result(spmm_csr_3d_reduce_graph(graph, data, x, {reduce})); },
+          "Agregacja CSR x [N,H,D] z redukcją sum/mean/max/min dla CSRGraph (z autograd); max/min zwracają (wartości, arg)",
+          py::arg("graph"), py::arg("data"), py::arg("x"), py::arg("reduce") = "sum");
+    m.def("spmm_csr_3d_reduce",
+          [](torch::Tensor indices, torch::Tensor indptr, c10::optional<torch::Tensor> data, torch::Tensor x,
+             const std::string &reduce, std::shared_ptr<CsrPartition> partition)
+          { return single_reduce_result(spmm_csr_3d_reduce(indices, indptr, data, x, {reduce}, partition)); },
+          "Agregacja CSR x [N,H,D] z redukcją sum/mean/max/min (z autograd); max/min zwracają (wartości, arg)",
+          py::arg("indices"), py::arg("indptr"), py::arg("data"), py::arg("x"), py::arg("reduce") = "sum",
+          py::arg("partition") = nullptr);
+    m.def("spmm_csr_3d_multi",
+          [](std::shared_ptr<CSRGraph> graph, c10::optional<torch::Tensor> data, torch::Tensor x,
+             const std::vector<std::string> &reduces)
+          { return multi_reduce_result(reduces, spmm_csr_3d_reduce_graph(graph, data, x, reduces)); },
+          "Kilka redukcji w jednym przejściu dla CSRGraph (z autograd): {redukcja: wynik, argmax/argmin}",
+          py::arg("graph"), py::arg("data"), py::arg("x"), py::arg("reduces"));
+    m.def("spmm_csr_3d_multi",
+          [](torch::Tensor indices, torch::Tensor indptr, c10::optional<torch::Tensor> data, torch::Tensor x,
+             const std::vector<std::string> &reduces, std::shared_ptr<CsrPartition> partition)
+          { return multi_reduce_result(reduces, spmm_csr_3d_reduce(indices, indptr, data, x, reduces, partition)); },
+          "Kilka redukcji (sum/mean/max/min) w jednym przejściu po CSR (z autograd): {redukcja: wynik, argmax/argmin}",
+          py::arg("indices"), py::arg("indptr"), py::arg("data"), py::arg("x"), py::arg("reduces"),
+          py::arg("partition") = nullptr);
+    m.def("spmm_csr_3d_channel", &spmm_csr_3d_channel_graph,
+          "Agregacja z wagami krawędzi na head i kanał weights [E,H,D] dla CSRGraph (z autograd)",
+          py::arg("graph"), py::arg("weights"), py::arg("x"));
+    m.def("spmm_csr_3d_channel", &spmm_csr_3d_channel,
+          "Agregacja z wagami krawędzi na head i kanał weights [E,H,D] (z autograd)",
+          py::arg("indices"), py::arg("indptr"), py::arg("weights"), py::arg("x"), py::arg("partition") = nullptr);
+    m.def("spmm_csr_3d_lowrank", &spmm_csr_3d_lowrank_graph,
+          "Agregacja z wagami niskiego rzędu coef [E,H,R] x basis [H,R,D] dla CSRGraph (z autograd); "
+          "z proj [F,H,R] coef to edge_attr [E,F]",
+          py::arg("graph"), py::arg("coef"), py::arg("basis"), py::arg("x"), py::arg("proj") = py::none());
+    m.def("spmm_csr_3d_lowrank", &spmm_csr_3d_lowrank,
+          "Agregacja z wagami niskiego rzędu coef [E,H,R] x basis [H,R,D] składanymi w jądrze (z autograd); "
+          "z proj [F,H,R] coef to edge_attr [E,F]",
+          py::arg("indices"), py::arg("indptr"), py::arg("coef"), py::arg("basis"), py::arg("x"),
+          py::arg("proj") = py::none(), py::arg("partition") = nullptr);
+    m.def("sddmm_csr", &sddmm_csr_graph,
+          "SDDMM dla CSRGraph: score[e,h] = scale * <q[row,h,:], k[col,h,:]> -> [E,H] (z autograd)",
+          py::arg("graph"), py::arg("q"), py::arg("k"), py::arg("scale") = 1.0);
+    m.def("sddmm_csr", &sddmm_csr,
+          "SDDMM po wzorcu CSR: score[e,h] = scale * <q[row,h,:], k[col,h,:]> -> [E,H] (z autograd)",
+          py::arg("indices"), py::arg("indptr"), py::arg("q"), py::arg("k"), py::arg("scale") = 1.0,
+          py::arg("partition") = nullptr);
+    m.def("gat_project", &gat_project,
+          "Projekcja GAT x @ W (BLAS) z alpha_src/alpha_dst w jednym przejściu po wyniku: (x_proj, alpha_src, alpha_dst) (z autograd)",
+          py::arg("x"), py::arg("W"), py::arg("a_src"), py::arg("a_dst"));
+    m.def("gat_fused_csr", &gat_fused_csr_graph, "GAT złączony dla CSRGraph (z autograd)",
+          py::arg("graph"), py::arg("alpha_src"), py::arg("alpha_dst"), py::arg("x_proj"), py::arg("negative_slope"));
+    m.def("gat_fused_csr", &gat_fused_csr, "GAT: LeakyReLU + softmax + agregacja w jednym przejściu po CSR (z autograd)",
+          py::arg("indices"), py::arg("indptr"), py::arg("alpha_src"), py::arg("alpha_dst"), py::arg("x_proj"),
+          py::arg("negative_slope"));
 }
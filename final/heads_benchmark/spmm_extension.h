@@ -0,0 +1,281 @@
+#pragma once
+
+#include <torch/extension.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "spmm_kernels.h"
+#include "csr_graph.h"
+#include "sampler.h"
+
+#ifndef SPMM_RECORD_FUNCTION
+#define SPMM_RECORD_FUNCTION 0
+#endif
+
+#if SPMM_RECORD_FUNCTION
+#include <ATen/record_function.h>
+#define SPMM_RECORD_SCOPE(name, ...) RECORD_FUNCTION("spmm_extension::" name, std::vector<c10::IValue>({__VA_ARGS__}))
+#else
+#define SPMM_RECORD_SCOPE(name, ...)
+#endif
+
+// Wspólne deklaracje operacji rozszerzenia spmm_extension.
+// Rejestracja w Pythonie (PYBIND11_MODULE) jest w spmm_extension.cpp.
+
+// Początek operacji: zakres torch.profiler (SPMM_RECORD_FUNCTION, z wejściami
+// do record_shapes) i licznik spmm_stats::OpScope o nazwie var
+// (SPMM_STATS, instrumentation.h). Przy wyłączonych makrach nic nie robi.
+#define SPMM_OP_SCOPE(var, name, ...) \
+    SPMM_RECORD_SCOPE(name, __VA_ARGS__); \
+    spmm_stats::OpScope var(name)
+
+// spmm_extension.cpp
+// num_parts <= 0 oznacza liczbę wątków OpenMP
+CsrPartition make_partition(torch::Tensor indptr, int64_t num_parts);
+
+torch::Tensor spmm_csr_3d(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor dense_matrix,
+    std::shared_ptr<CsrPartition> partition = nullptr,
+    c10::optional<at::ScalarType> out_dtype = c10::nullopt);
+
+// wersja dla skompilowanego grafu (csr_graph.h)
+torch::Tensor spmm_csr_3d_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    torch::Tensor dense_matrix,
+    c10::optional<at::ScalarType> out_dtype = c10::nullopt);
+
+std::vector<torch::Tensor> csr_transpose(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    int64_t num_cols);
+
+// Jądra forward/backward spmm_csr_3d (bez autograd), używane też przez inne
+// operacje: wynik w fp32, data [E,H], grad_out [rows,H,D].
+torch::Tensor spmm_csr_3d_forward(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor dense_matrix,
+    const CsrPartition &part);
+
+torch::Tensor spmm_csr_3d_backward_data(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor grad_out,
+    torch::Tensor dense_matrix,
+    const CsrPartition &part);
+
+torch::Tensor spmm_csr_3d_backward_dense(
+    torch::Tensor t_indptr,
+    torch::Tensor t_rows,
+    torch::Tensor t_perm,
+    torch::Tensor data,
+    torch::Tensor grad_out,
+    const CsrPartition &part_t);
+
+// instrumentation.cpp
+// Liczniki operacji jako {nazwa: {calls, time_ms, edges, bytes, alloc_bytes,
+// max_alloc_bytes, thread_busy_ms, imbalance}}; reset = true zeruje liczniki.
+py::dict stats(bool reset);
+
+// coo_csr.cpp
+std::vector<torch::Tensor> coo_to_csr(
+    torch::Tensor row,
+    torch::Tensor col,
+    c10::optional<torch::Tensor> values,
+    int64_t num_nodes,
+    bool with_csc,
+    bool merge_duplicates,
+    bool add_self_loops,
+    double self_loop_value);
+
+// reorder.cpp
+torch::Tensor reorder_permutation(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    const std::string &method,
+    int64_t max_iterations);
+
+std::vector<torch::Tensor> permute_csr(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    torch::Tensor perm);
+
+std::shared_ptr<CSRGraph> reorder_graph(
+    torch::Tensor indptr,
+    torch::Tensor indices,
+    const std::string &method,
+    int64_t num_parts,
+    int64_t max_iterations);
+
+torch::Tensor permute_nodes(std::shared_ptr<CSRGraph> graph, torch::Tensor x);
+
+torch::Tensor unpermute_nodes(std::shared_ptr<CSRGraph> graph, torch::Tensor y);
+
+std::unordered_map<std::string, double> locality_report(torch::Tensor indptr, torch::Tensor indices);
+
+// sampler.cpp
+struct CsrNeighborSampler
+{
+    torch::Tensor indptr;
+    torch::Tensor indices;
+    int64_t num_nodes = 0;
+    std::unique_ptr<NeighborSampler> sampler;
+
+    CsrNeighborSampler(torch::Tensor indptr, torch::Tensor indices, int64_t seed);
+
+    std::vector<torch::Tensor> sample(
+        torch::Tensor seeds,
+        const std::vector<int64_t> &fanouts,
+        int64_t batch_key);
+};
+
+// quantized.cpp
+// Cechy [N,H,D] (albo [N,F], wtedy H = 1) w int8 ze skalą i punktem zera
+// na wiersz (per_head = false, scale [N]) albo na wiersz i head
+// (per_head = true, scale [N,H]): x ≈ scale * (q - zero_point).
+struct QuantizedFeatures
+{
+    torch::Tensor q;          // int8, kształt x
+    torch::Tensor scale;      // float32
+    torch::Tensor zero_point; // int32
+    int64_t num_nodes = 0;
+    int64_t H = 0;
+    int64_t D = 0;
+    bool per_head = false;
+
+    static std::shared_ptr<QuantizedFeatures> build(torch::Tensor x, bool per_head);
+
+    torch::Tensor dequantize() const;
+    int64_t nbytes() const;
+};
+
+torch::Tensor spmm_csr_3d_int8(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    std::shared_ptr<QuantizedFeatures> features,
+    std::shared_ptr<CsrPartition> partition = nullptr);
+
+torch::Tensor spmm_csr_3d_int8_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    std::shared_ptr<QuantizedFeatures> features);
+
+// gat_fused.cpp
+torch::Tensor gat_fused_csr(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor alpha_src,
+    torch::Tensor alpha_dst,
+    torch::Tensor x_proj,
+    double negative_slope);
+
+torch::Tensor gat_fused_csr_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor alpha_src,
+    torch::Tensor alpha_dst,
+    torch::Tensor x_proj,
+    double negative_slope);
+
+// reductions.cpp
+// Agregacja z redukcjami sum/mean/max/min w jednym przejściu (data = None -
+// wagi 1). Wynik: wartości w kolejności reduces, potem argmax/argmin
+// (numery krawędzi, -1 dla wierszy bez krawędzi) dla każdego max/min.
+std::vector<torch::Tensor> spmm_csr_3d_reduce(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    c10::optional<torch::Tensor> data,
+    torch::Tensor x,
+    const std::vector<std::string> &reduces,
+    std::shared_ptr<CsrPartition> partition = nullptr);
+
+std::vector<torch::Tensor> spmm_csr_3d_reduce_graph(
+    std::shared_ptr<CSRGraph> graph,
+    c10::optional<torch::Tensor> data,
+    torch::Tensor x,
+    const std::vector<std::string> &reduces);
+
+// anisotropic.cpp
+// Wagi krawędzi na head i kanał: weights [E,H,D] albo niskiego rzędu
+// coef [E,H,R] x basis [H,R,D]; z proj [F,H,R] coef to edge_attr [E,F]
+// (współczynniki edge_attr @ proj liczone w jądrze).
+torch::Tensor spmm_csr_3d_channel(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor weights,
+    torch::Tensor x,
+    std::shared_ptr<CsrPartition> partition = nullptr);
+
+torch::Tensor spmm_csr_3d_channel_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor weights,
+    torch::Tensor x);
+
+torch::Tensor spmm_csr_3d_lowrank(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor coef,
+    torch::Tensor basis,
+    torch::Tensor x,
+    c10::optional<torch::Tensor> proj,
+    std::shared_ptr<CsrPartition> partition = nullptr);
+
+torch::Tensor spmm_csr_3d_lowrank_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor coef,
+    torch::Tensor basis,
+    torch::Tensor x,
+    c10::optional<torch::Tensor> proj);
+
+// sddmm.cpp
+// score[e,h] = scale * <q[row(e),h,:], k[col(e),h,:]> po wzorcu CSR -> [E,H]
+torch::Tensor sddmm_csr(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor q,
+    torch::Tensor k,
+    double scale = 1.0,
+    std::shared_ptr<CsrPartition> partition = nullptr);
+
+torch::Tensor sddmm_csr_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor q,
+    torch::Tensor k,
+    double scale = 1.0);
+
+// gat_project.cpp
+// (x_proj [N,H,D], alpha_src [N,H], alpha_dst [N,H]) z x [N,F], W [F,H*D]
+// i a_src/a_dst [H,D]: x @ W w BLAS, oba alpha w jednym przejściu po x_proj
+std::vector<torch::Tensor> gat_project(
+    torch::Tensor x,
+    torch::Tensor W,
+    torch::Tensor a_src,
+    torch::Tensor a_dst);
+
+// layouts.cpp
+torch::Tensor to_layout(torch::Tensor x, const std::string &layout, int64_t block);
+
+torch::Tensor from_layout(torch::Tensor x, const std::string &layout, int64_t num_nodes);
+
+torch::Tensor spmm_csr_3d_layout(
+    torch::Tensor indices,
+    torch::Tensor indptr,
+    torch::Tensor data,
+    torch::Tensor x,
+    const std::string &layout,
+    std::shared_ptr<CsrPartition> partition,
+    int64_t head_block);
+
+torch::Tensor spmm_csr_3d_layout_graph(
+    std::shared_ptr<CSRGraph> graph,
+    torch::Tensor data,
+    torch::Tensor x,
+    const std::string &layout,
+    int64_t head_block);
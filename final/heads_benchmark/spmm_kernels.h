@@ -0,0 +1,487 @@
+#pragma once
+
+#include "csr_partition.h"
+#include "instrumentation.h"
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SPMM_X86_TARGETS 1
+#endif
+
+// Jądra SpMM CSR x [N,H,D] na surowych wskaźnikach (bez zależności od torcha),
+// współdzielone przez operacje rozszerzenia.
+
+// Układy pamięci tensora cech. Wiersz (węzeł n, head h) o długości D zaczyna
+// się pod adresem offset(n) + h * head_stride().
+
+// [N,H,D] - domyślny, wszystkie heady węzła obok siebie
+struct NodeMajorLayout
+{
+    int64_t H, D;
+    int64_t offset(int64_t n) const { return n * H * D; }
+    int64_t head_stride() const { return D; }
+};
+
+// [H,N,D] - osobna "płaszczyzna" N*D dla każdego heada
+struct HeadMajorLayout
+{
+    int64_t N, D;
+    int64_t offset(int64_t n) const { return n * D; }
+    int64_t head_stride() const { return N * D; }
+};
+
+// [N/B,H,B,D] - kafle po B węzłów (B potęga dwójki), w kaflu head-major
+struct TiledLayout
+{
+    int64_t H, D, log2_block;
+    int64_t block() const { return int64_t(1) << log2_block; }
+    int64_t offset(int64_t n) const
+    {
+        return (((n >> log2_block) * H << log2_block) + (n & (block() - 1))) * D;
+    }
+    int64_t head_stride() const { return block() * D; }
+};
+
+// Typy przechowywania 16-bitowego (surowe bity, ten sam układ co at::Half
+// i at::BFloat16). data i x mogą być w fp16/bf16, ale akumulacja i carry są
+// zawsze w fp32 - połowa bajtów na każdy czytany wiersz sąsiada.
+struct Fp16
+{
+    uint16_t bits;
+};
+
+struct Bf16
+{
+    uint16_t bits;
+};
+
+inline float to_float(float x) { return x; }
+
+// bf16 to górne 16 bitów fp32
+inline float to_float(Bf16 x)
+{
+    uint32_t u = uint32_t(x.bits) << 16;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Konwersja programowa (bez F16C), używana przez jądra ogólne.
+inline float to_float(Fp16 x)
+{
+    uint32_t sign = uint32_t(x.bits & 0x8000) << 16;
+    uint32_t exponent = (x.bits >> 10) & 0x1f;
+    uint32_t mantissa = x.bits & 0x3ff;
+    uint32_t u;
+    if (exponent == 0)
+    {
+        // zero albo liczba subnormalna: mantissa * 2^-24
+        float f = float(mantissa) * 5.9604644775390625e-8f;
+        return sign ? -f : f;
+    }
+    if (exponent == 31)
+    {
+        u = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else
+    {
+        u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Wejście jądra: wzorzec CSR, wagi data[E,H] i cechy x w układzie Layout,
+// przechowywane jako T (float, Fp16 albo Bf16).
+template <class Layout, class T = float>
+struct SpmmInput
+{
+    const int64_t *indices;
+    const T *data;
+    const T *x;
+    Layout layout;
+    int64_t H;
+    int64_t D;
+};
+
+// Funkcja: spmm_row_segment
+// out[h - h_begin, :] = ∑_{i w [begin,end)} data[i,h] * x[indices[i],h,:]  dla h w [h_begin,h_end)
+// Kolejne heady w out są co out_head_stride. Wynik jest nadpisywany (a nie
+// dodawany), więc out nie musi być wyzerowany.
+template <class Layout, class T>
+inline void spmm_row_segment(
+    const SpmmInput<Layout, T> &in,
+    int64_t begin,
+    int64_t end,
+    int64_t h_begin,
+    int64_t h_end,
+    float *out,
+    int64_t out_head_stride)
+{
+    const int64_t H = in.H;
+    const int64_t D = in.D;
+
+    for (int64_t h = h_begin; h < h_end; h++)
+    {
+        float *out_head = out + (h - h_begin) * out_head_stride;
+        std::fill(out_head, out_head + D, 0.0f);
+    }
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        const T *in_row = in.x + in.layout.offset(in.indices[i]);
+
+        for (int64_t h = h_begin; h < h_end; h++)
+        {
+            float edge_weight = to_float(in.data[i * H + h]);
+            const T *in_head = in_row + h * in.layout.head_stride();
+            float *out_head = out + (h - h_begin) * out_head_stride;
+            for (int64_t d = 0; d < D; d++)
+            {
+                out_head[d] += edge_weight * to_float(in_head[d]);
+            }
+        }
+    }
+}
+
+// Wersje ze stałym D (8/16/32/64). Akumulator wiersza dla heada h jest trzymany
+// w rejestrach przez wszystkie krawędzie fragmentu i zapisywany raz na końcu,
+// zamiast odczytu-modyfikacji-zapisu out przy każdej krawędzi.
+// Wersje AVX2/AVX-512 (FMA) kompilowane są atrybutem target, a wybór
+// następuje w czasie działania na podstawie CPU (select_row_segment).
+// Wejście 16-bitowe jest rozszerzane do fp32 przy ładowaniu: fp16 przez
+// F16C (AVX2) albo vcvtph2ps (AVX-512F), bf16 przesunięciem o 16 bitów.
+
+template <class Layout, class T = float>
+using RowSegmentFn = void (*)(const SpmmInput<Layout, T> &, int64_t, int64_t, int64_t, int64_t, float *, int64_t);
+
+template <int D, class Layout, class T>
+void spmm_row_segment_fixed(
+    const SpmmInput<Layout, T> &in,
+    int64_t begin,
+    int64_t end,
+    int64_t h_begin,
+    int64_t h_end,
+    float *out,
+    int64_t out_head_stride)
+{
+    const int64_t H = in.H;
+
+    for (int64_t h = h_begin; h < h_end; h++)
+    {
+        float acc[D] = {};
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            float edge_weight = to_float(in.data[i * H + h]);
+            const T *in_row = in.x + in.layout.offset(in.indices[i]) + h * in.layout.head_stride();
+#pragma omp simd
+            for (int d = 0; d < D; d++)
+            {
+                acc[d] += edge_weight * to_float(in_row[d]);
+            }
+        }
+
+        std::copy(acc, acc + D, out + (h - h_begin) * out_head_stride);
+    }
+}
+
+#ifdef SPMM_X86_TARGETS
+
+// Ładowanie 8 (AVX2) / 16 (AVX-512) wartości jako fp32.
+__attribute__((target("avx2,fma,f16c"))) inline __m256 load8_ps(const float *p)
+{
+    return _mm256_loadu_ps(p);
+}
+
+__attribute__((target("avx2,fma,f16c"))) inline __m256 load8_ps(const Fp16 *p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+__attribute__((target("avx2,fma,f16c"))) inline __m256 load8_ps(const Bf16 *p)
+{
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+}
+
+__attribute__((target("avx512f"))) inline __m512 load16_ps(const float *p)
+{
+    return _mm512_loadu_ps(p);
+}
+
+__attribute__((target("avx512f"))) inline __m512 load16_ps(const Fp16 *p)
+{
+    return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+
+__attribute__((target("avx512f"))) inline __m512 load16_ps(const Bf16 *p)
+{
+    __m512i wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(wide, 16));
+}
+
+template <int D, class Layout, class T>
+__attribute__((target("avx2,fma,f16c"))) void spmm_row_segment_avx2(
+    const SpmmInput<Layout, T> &in,
+    int64_t begin,
+    int64_t end,
+    int64_t h_begin,
+    int64_t h_end,
+    float *out,
+    int64_t out_head_stride)
+{
+    static_assert(D % 8 == 0, "D must be a multiple of 8");
+    constexpr int V = D / 8;
+    const int64_t H = in.H;
+
+    for (int64_t h = h_begin; h < h_end; h++)
+    {
+        __m256 acc[V];
+#pragma GCC unroll 8
+        for (int v = 0; v < V; v++)
+        {
+            acc[v] = _mm256_setzero_ps();
+        }
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            __m256 w = _mm256_set1_ps(to_float(in.data[i * H + h]));
+            const T *in_row = in.x + in.layout.offset(in.indices[i]) + h * in.layout.head_stride();
+#pragma GCC unroll 8
+            for (int v = 0; v < V; v++)
+            {
+                acc[v] = _mm256_fmadd_ps(w, load8_ps(in_row + 8 * v), acc[v]);
+            }
+        }
+
+        float *out_head = out + (h - h_begin) * out_head_stride;
+#pragma GCC unroll 8
+        for (int v = 0; v < V; v++)
+        {
+            _mm256_storeu_ps(out_head + 8 * v, acc[v]);
+        }
+    }
+}
+
+template <int D, class Layout, class T>
+__attribute__((target("avx512f"))) void spmm_row_segment_avx512(
+    const SpmmInput<Layout, T> &in,
+    int64_t begin,
+    int64_t end,
+    int64_t h_begin,
+    int64_t h_end,
+    float *out,
+    int64_t out_head_stride)
+{
+    static_assert(D % 16 == 0, "D must be a multiple of 16");
+    constexpr int V = D / 16;
+    const int64_t H = in.H;
+
+    for (int64_t h = h_begin; h < h_end; h++)
+    {
+        __m512 acc[V];
+#pragma GCC unroll 4
+        for (int v = 0; v < V; v++)
+        {
+            acc[v] = _mm512_setzero_ps();
+        }
+
+        for (int64_t i = begin; i < end; i++)
+        {
+            __m512 w = _mm512_set1_ps(to_float(in.data[i * H + h]));
+            const T *in_row = in.x + in.layout.offset(in.indices[i]) + h * in.layout.head_stride();
+#pragma GCC unroll 4
+            for (int v = 0; v < V; v++)
+            {
+                acc[v] = _mm512_fmadd_ps(w, load16_ps(in_row + 16 * v), acc[v]);
+            }
+        }
+
+        float *out_head = out + (h - h_begin) * out_head_stride;
+#pragma GCC unroll 4
+        for (int v = 0; v < V; v++)
+        {
+            _mm512_storeu_ps(out_head + 16 * v, acc[v]);
+        }
+    }
+}
+
+inline bool cpu_has_avx2_fma()
+{
+    // F16C jest na wszystkich CPU z AVX2, ale sprawdzamy ją jawnie (load8_ps)
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                            __builtin_cpu_supports("f16c");
+    return has;
+}
+
+inline bool cpu_has_avx512f()
+{
+    static const bool has = __builtin_cpu_supports("avx512f");
+    return has;
+}
+
+#endif // SPMM_X86_TARGETS
+
+// Zwraca jądro dla danego D albo nullptr (wtedy używamy spmm_row_segment).
+template <class Layout, class T = float>
+inline RowSegmentFn<Layout, T> select_row_segment(int64_t D)
+{
+#ifdef SPMM_X86_TARGETS
+    if (cpu_has_avx512f())
+    {
+        switch (D)
+        {
+        case 16: return &spmm_row_segment_avx512<16, Layout, T>;
+        case 32: return &spmm_row_segment_avx512<32, Layout, T>;
+        case 64: return &spmm_row_segment_avx512<64, Layout, T>;
+        }
+    }
+    if (cpu_has_avx2_fma())
+    {
+        switch (D)
+        {
+        case 8: return &spmm_row_segment_avx2<8, Layout, T>;
+        case 16: return &spmm_row_segment_avx2<16, Layout, T>;
+        case 32: return &spmm_row_segment_avx2<32, Layout, T>;
+        case 64: return &spmm_row_segment_avx2<64, Layout, T>;
+        }
+    }
+#endif
+    switch (D)
+    {
+    case 8: return &spmm_row_segment_fixed<8, Layout, T>;
+    case 16: return &spmm_row_segment_fixed<16, Layout, T>;
+    case 32: return &spmm_row_segment_fixed<32, Layout, T>;
+    case 64: return &spmm_row_segment_fixed<64, Layout, T>;
+    }
+    return nullptr;
+}
+
+// Funkcja: spmm_partitioned_rows
+// Szkielet równoległej agregacji po wierszach CSR z podziałem merge-path:
+// dla każdego fragmentu wiersza woła
+//   segment(begin, end, h_begin, h_end, out, out_head_stride),
+// który nadpisuje out[h - h_begin, :] sumą po krawędziach [begin, end).
+// Części podziału liczone są równolegle, a fragmenty wierszy dzielonych
+// między części (carry) doliczane szeregowo na końcu.
+//
+// Heady przetwarzane są blokami po head_block, każdy blok to osobne przejście
+// po grafie. head_block == H to jedno przejście ze wszystkimi headami wiersza
+// naraz (układ [N,H,D]); head_block == 1 to heady "na zewnątrz", gdzie każde
+// przejście czyta tylko jedną płaszczyznę N*D (układ [H,N,D]).
+template <class OutLayout, class Segment>
+inline void spmm_partitioned_rows(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    int64_t H,
+    int64_t D,
+    float *result,
+    const OutLayout &out_layout,
+    int64_t head_block,
+    const Segment &segment)
+{
+    head_block = std::min<int64_t>(std::max<int64_t>(head_block, 1), H);
+
+    int64_t P = part.num_parts();
+    std::vector<float> carry(P * head_block * D, 0.0f);
+    std::vector<int64_t> carry_row(P);
+    spmm_stats::record_alloc(static_cast<int64_t>(carry.size() * sizeof(float) + carry_row.size() * sizeof(int64_t)));
+    spmm_stats::OpScope *op = spmm_stats::OpScope::current();
+
+    for (int64_t h_begin = 0; h_begin < H; h_begin += head_block)
+    {
+        int64_t h_end = std::min(H, h_begin + head_block);
+        std::fill(carry_row.begin(), carry_row.end(), -1);
+
+#pragma omp parallel for schedule(static, 1)
+        for (int64_t p = 0; p < P; p++)
+        {
+            spmm_stats::BusyScope busy(op);
+            part.for_each_segment(p, indptr, [&](int64_t p, int64_t row, int64_t begin, int64_t end, bool row_ends_here)
+            {
+                float *out = carry.data() + p * head_block * D;
+                int64_t out_head_stride = D;
+                if (row_ends_here)
+                {
+                    out = result + out_layout.offset(row) + h_begin * out_layout.head_stride();
+                    out_head_stride = out_layout.head_stride();
+                }
+                else
+                {
+                    carry_row[p] = row;
+                }
+
+                segment(begin, end, h_begin, h_end, out, out_head_stride);
+            });
+        }
+
+        for (int64_t p = 0; p < P; p++)
+        {
+            if (carry_row[p] < 0)
+            {
+                continue;
+            }
+            for (int64_t h = h_begin; h < h_end; h++)
+            {
+                float *out_row = result + out_layout.offset(carry_row[p]) + h * out_layout.head_stride();
+                const float *c = carry.data() + (p * head_block + (h - h_begin)) * D;
+                for (int64_t d = 0; d < D; d++)
+                {
+                    out_row[d] += c[d];
+                }
+            }
+        }
+    }
+}
+
+// Funkcja: spmm_csr_3d_partitioned
+// result[row,h,:] = ∑_{edge w wierszu row} data[edge,h] * x[col(edge),h,:]
+// (spmm_partitioned_rows z jądrem wiersza wybranym dla D i CPU).
+template <class InLayout, class OutLayout, class T>
+inline void spmm_csr_3d_partitioned(
+    const CsrPartition &part,
+    const int64_t *indptr,
+    const SpmmInput<InLayout, T> &in,
+    float *result,
+    const OutLayout &out_layout,
+    int64_t head_block)
+{
+    RowSegmentFn<InLayout, T> fixed = select_row_segment<InLayout, T>(in.D);
+
+    spmm_partitioned_rows(part, indptr, in.H, in.D, result, out_layout, head_block,
+                          [&](int64_t begin, int64_t end, int64_t h_begin, int64_t h_end, float *out, int64_t out_head_stride)
+    {
+        if (fixed)
+        {
+            fixed(in, begin, end, h_begin, h_end, out, out_head_stride);
+        }
+        else
+        {
+            spmm_row_segment(in, begin, end, h_begin, h_end, out, out_head_stride);
+        }
+    });
+}
+
+// Wariant dla domyślnego układu [N,H,D] (wejście i wynik), wynik w fp32.
+template <class T>
+inline void spmm_csr_3d_partitioned(
+    const CsrPartition &part,
+    const int64_t *indices,
+    const int64_t *indptr,
+    const T *data,
+    const T *dense,
+    int64_t H,
+    int64_t D,
+    float *result)
+{
+    NodeMajorLayout layout{H, D};
+    SpmmInput<NodeMajorLayout, T> in{indices, data, dense, layout, H, D};
+    spmm_csr_3d_partitioned(part, indptr, in, result, layout, H);
+}
@@ -1,3 +1,4 @@
+import os
 from setuptools import setup
 from torch.utils.cpp_extension import CppExtension, BuildExtension
 
@@ -7,6 +8,8 @@ setup(
         CppExtension(
             name='spmm_extension',
             sources=['spmm_extension.cpp'],
+            # csr_partition.h jest wspólny z heads_benchmark
+            include_dirs=[os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'heads_benchmark')],
             extra_compile_args=['-fopenmp'],  # flaga dla OpenMP
         )
     ],
@@ -1,5 +1,8 @@
 #include <torch/extension.h>
 #include <omp.h>
+#include <vector>
+
+#include "csr_partition.h"
 
 // Funkcja: spmm_csr_3d
 // Mnoży macierz rzadka w formacie CSR przez macierz gęstą 3D.
@@ -43,24 +46,54 @@ torch::Tensor spmm_csr_3d(
     // result[row,h,d] = result_ptr[row*H*D + h*D + d]
     // dense_matrix[col,h,d] = dense_ptr[col*H*D + h*D + d]
 
-#pragma omp parallel for collapse(2)
-    for (int64_t row = 0; row < num_rows; row++)
+    // Podział merge-path: części o równej liczbie (wierszy + krawędzi), wiersz
+    // kończący się w części p jest pisany tylko przez nią, a początek wiersza
+    // dzielonego z poprzednią częścią trafia do carry i jest doliczany na końcu.
+    CsrPartition part = CsrPartition::build(indptr_ptr, num_rows, omp_get_max_threads());
+    int64_t P = part.num_parts();
+    std::vector<float> carry(P * H * D, 0.0f);
+    std::vector<int64_t> carry_row(P, -1);
+
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t p = 0; p < P; p++)
     {
-        for (int64_t i = indptr_ptr[row]; i < indptr_ptr[row + 1]; i++)
+        part.for_each_segment(p, indptr_ptr, [&](int64_t p, int64_t row, int64_t begin, int64_t end, bool row_ends_here)
         {
-            int64_t col = indices_ptr[i];
-            const float *in_row = dense_ptr + col * H * D;
+            float *out = row_ends_here ? result_ptr + row * H * D : carry.data() + p * H * D;
+            if (!row_ends_here)
+            {
+                carry_row[p] = row;
+            }
 
-            for (int64_t h = 0; h < H; h++)
+            for (int64_t i = begin; i < end; i++)
             {
-                float edge_weight = data_ptr[i * H + h]; // data[i,h]
-                float *out_row = result_ptr + row * H * D + h * D;
+                int64_t col = indices_ptr[i];
+                const float *in_row = dense_ptr + col * H * D;
 
-                for (int64_t d = 0; d < D; d++)
+                for (int64_t h = 0; h < H; h++)
                 {
-                    out_row[d] += edge_weight * in_row[h * D + d];
+                    float edge_weight = data_ptr[i * H + h]; // data[i,h]
+                    float *out_row = out + h * D;
+
+                    for (int64_t d = 0; d < D; d++)
+                    {
+                        out_row[d] += edge_weight * in_row[h * D + d];
+                    }
                 }
             }
+        });
+    }
+
+    for (int64_t p = 0; p < P; p++)
+    {
+        if (carry_row[p] < 0)
+        {
+            continue;
+        }
+        float *out_row = result_ptr + carry_row[p] * H * D;
+        for (int64_t k = 0; k < H * D; k++)
+        {
+            out_row[k] += carry[p * H * D + k];
         }
     }
 
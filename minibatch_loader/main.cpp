@@ -1,20 +1,35 @@
-#include <torch/torch.h>
+#include "minibatch_loader.h"
+
+#include <chrono>
 #include <iostream>
-#include <filesystem>
+#include <string>
+
+// Użycie: my_project [katalog] [wątki] [prefetch] [shuffle 0/1]
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "./"; // Ścieżka do plików z minibatchami
 
-namespace fs = std::filesystem;
+    LoaderOptions options;
+    options.num_workers = argc > 2 ? std::stoi(argv[2]) : 2;
+    options.prefetch_depth = argc > 3 ? std::stoul(argv[3]) : 4;
+    options.shuffle = argc > 4 && std::string(argv[4]) == "1";
 
-int main() {
-    std::string path = "./"; // Ścieżka do plików z minibatchami
+    auto start = std::chrono::steady_clock::now();
+    MinibatchLoader loader(listMinibatchFiles(path), options);
 
-    for (const auto &entry : fs::directory_iterator(path)) {
-        if (entry.path().extension() == ".pt") {
-            torch::Tensor batch;
-            torch::load(batch, entry.path().string());
-            std::cout << "Wczytano minibatch z pliku: " << entry.path() << std::endl;
-            std::cout << "Rozmiar tensora: " << batch.sizes() << std::endl;
+    Minibatch batch;
+    while (loader.next(batch)) {
+        std::cout << "Wczytano minibatch z pliku: " << batch.path << std::endl;
+        for (const auto& entry : batch.tensors) {
+            std::cout << "  " << entry.first << ": " << entry.second.sizes() << std::endl;
         }
     }
 
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LoaderStats stats = loader.stats();
+    std::cout << "Minibatche: " << stats.batches << ", czas: " << total_ms << " ms" << std::endl;
+    std::cout << "Oczekiwanie na dane (starvation): " << stats.starvation_ms << " ms" << std::endl;
+    std::cout << "Wczytywanie (suma po wątkach): " << stats.load_ms << " ms" << std::endl;
+    std::cout << "Wątki zablokowane na pełnej kolejce: " << stats.blocked_ms << " ms" << std::endl;
+
     return 0;
 }
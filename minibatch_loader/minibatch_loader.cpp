@@ -0,0 +1,164 @@
+#include "minibatch_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+Minibatch loadMinibatch(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // plik z torch.save w Pythonie (format zip) - czytany przez pickle_load
+    c10::IValue value = torch::pickle_load(bytes);
+
+    Minibatch batch;
+    batch.path = path;
+    if (value.isTensor()) {
+        batch.tensors["tensor"] = value.toTensor();
+    } else if (value.isGenericDict()) {
+        for (const auto& entry : value.toGenericDict()) {
+            if (!entry.key().isString() || !entry.value().isTensor()) {
+                throw std::runtime_error("Minibatch " + path + " must be a dict of str -> Tensor");
+            }
+            batch.tensors[entry.key().toStringRef()] = entry.value().toTensor();
+        }
+    } else {
+        throw std::runtime_error("Minibatch " + path + " must be a Tensor or a dict of tensors");
+    }
+    return batch;
+}
+
+std::vector<std::string> listMinibatchFiles(const std::string& dir, const std::string& extension) {
+    std::vector<std::string> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == extension) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+MinibatchLoader::MinibatchLoader(std::vector<std::string> files, const LoaderOptions& options)
+    : files_(std::move(files)), options_(options) {
+    if (options_.num_workers < 1) {
+        throw std::invalid_argument("num_workers must be at least 1");
+    }
+    if (options_.prefetch_depth < 1) {
+        throw std::invalid_argument("prefetch_depth must be at least 1");
+    }
+    if (options_.shuffle) {
+        std::mt19937_64 rng(options_.seed);
+        std::shuffle(files_.begin(), files_.end(), rng);
+    }
+
+    // destruktor nie zostanie wywołany, gdy konstruktor rzuci wyjątek, więc
+    // wątki uruchomione przed nieudanym std::thread trzeba dołączyć tutaj
+    try {
+        for (int i = 0; i < options_.num_workers; i++) {
+            workers_.emplace_back(&MinibatchLoader::worker, this);
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+}
+
+MinibatchLoader::~MinibatchLoader() {
+    stopWorkers();
+}
+
+void MinibatchLoader::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    space_cv_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+void MinibatchLoader::worker() {
+    while (true) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto start = std::chrono::steady_clock::now();
+            // batch jest pobierany tylko w oknie prefetch_depth za konsumentem
+            space_cv_.wait(lock, [&] {
+                return stop_ || next_claim_ >= files_.size() || next_claim_ < consumed_ + options_.prefetch_depth;
+            });
+            stats_.blocked_ms += elapsedMs(start);
+            if (stop_ || next_claim_ >= files_.size()) {
+                return;
+            }
+            index = next_claim_++;
+        }
+
+        Slot slot;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            slot.batch = loadMinibatch(files_[index]);
+        } catch (...) {
+            slot.error = std::current_exception();
+        }
+        slot.batch.index = index;
+        double load_ms = elapsedMs(start);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.load_ms += load_ms;
+            ready_.emplace(index, std::move(slot));
+        }
+        ready_cv_.notify_all();
+    }
+}
+
+bool MinibatchLoader::next(Minibatch& batch) {
+    Slot slot;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (consumed_ >= files_.size()) {
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        ready_cv_.wait(lock, [&] { return ready_.count(consumed_) > 0; });
+        stats_.starvation_ms += elapsedMs(start);
+
+        auto it = ready_.find(consumed_);
+        slot = std::move(it->second);
+        ready_.erase(it);
+        consumed_++;
+        stats_.batches++;
+    }
+    space_cv_.notify_all();
+
+    if (slot.error) {
+        std::rethrow_exception(slot.error);
+    }
+    batch = std::move(slot.batch);
+    return true;
+}
+
+LoaderStats MinibatchLoader::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
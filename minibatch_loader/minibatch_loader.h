@@ -0,0 +1,100 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ustawienia ładowania minibatchy.
+//   num_workers    - wątki czytające i dekodujące pliki .pt,
+//   prefetch_depth - ile batchy może być wczytanych (lub w trakcie
+//                    wczytywania) ponad ten, który konsument właśnie pobiera,
+//   shuffle        - losowa kolejność plików (deterministyczna dla seed).
+struct LoaderOptions {
+    int num_workers = 2;
+    size_t prefetch_depth = 4;
+    bool shuffle = false;
+    uint64_t seed = 0;
+};
+
+// Jeden wczytany minibatch: tensory ze słownika zapisanego w Pythonie
+// (torch.save({...}) jak w minibatch_saver.py). Plik z pojedynczym tensorem
+// daje wpis "tensor".
+struct Minibatch {
+    size_t index = 0;  // pozycja w kolejności epoki
+    std::string path;
+    std::map<std::string, torch::Tensor> tensors;
+};
+
+// Czasy w milisekundach.
+//   starvation_ms - ile konsument czekał w next() na niegotowy batch;
+//                   wyraźnie > 0 oznacza, że ładowanie nie nadąża (I/O bound),
+//   load_ms       - suma czasów wczytania + dekodowania we wszystkich wątkach,
+//   blocked_ms    - ile wątki czekały na miejsce w kolejce (konsument wolniejszy).
+struct LoaderStats {
+    size_t batches = 0;
+    double starvation_ms = 0.0;
+    double load_ms = 0.0;
+    double blocked_ms = 0.0;
+};
+
+// Wczytuje pojedynczy plik .pt z minibatchem.
+Minibatch loadMinibatch(const std::string& path);
+
+// Pliki o danym rozszerzeniu w katalogu, posortowane po nazwie.
+std::vector<std::string> listMinibatchFiles(const std::string& dir, const std::string& extension = ".pt");
+
+// Ładowarka minibatchy z prefetchem.
+//
+// Wątki robocze pobierają kolejne pliki z listy (po ewentualnym
+// przetasowaniu) i wczytują je w tle, najwyżej prefetch_depth batchy
+// naprzód. next() oddaje batche zawsze w kolejności epoki, niezależnie od
+// tego, który wątek skończył pierwszy. Błąd wczytania pliku jest rzucany
+// z next() dla tego batcha.
+//
+// Jeden obiekt to jedna epoka; kolejna epoka to nowy obiekt (np. z seed
+// powiększonym o numer epoki).
+class MinibatchLoader {
+public:
+    MinibatchLoader(std::vector<std::string> files, const LoaderOptions& options);
+    ~MinibatchLoader();
+
+    MinibatchLoader(const MinibatchLoader&) = delete;
+    MinibatchLoader& operator=(const MinibatchLoader&) = delete;
+
+    // false, gdy wszystkie batche epoki zostały już pobrane
+    bool next(Minibatch& batch);
+
+    size_t size() const { return files_.size(); }
+    LoaderStats stats() const;
+
+private:
+    struct Slot {
+        Minibatch batch;
+        std::exception_ptr error;
+    };
+
+    void worker();
+    // zatrzymuje i dołącza wszystkie uruchomione wątki
+    void stopWorkers();
+
+    std::vector<std::string> files_;
+    LoaderOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;  // batch gotowy dla konsumenta
+    std::condition_variable space_cv_;  // miejsce na kolejny batch
+    std::map<size_t, Slot> ready_;
+    size_t next_claim_ = 0;
+    size_t consumed_ = 0;
+    bool stop_ = false;
+    LoaderStats stats_;
+
+    std::vector<std::thread> workers_;
+};
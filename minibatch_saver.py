@@ -1,17 +1,40 @@
 import torch
-from torch_geometric.data import DataLoader
 from ogb.nodeproppred import PygNodePropPredDataset
+import spmm_extension
+
+BATCH_SIZE = 1024
+FANOUTS = [15, 10]  # liczba próbkowanych sąsiadów w kolejnych skokach
+SEED = 42
 
 # Ładowanie danych
 dataset = PygNodePropPredDataset(name='ogbn-arxiv')
 split_idx = dataset.get_idx_split()
 data = dataset[0]
+num_nodes = data.num_nodes
+
+# CSR po węzłach docelowych: wiersz - węzeł docelowy, indices - jego źródła
+indptr, indices = spmm_extension.coo_to_csr(data.edge_index[1], data.edge_index[0], None, num_nodes)[:2]
+sampler = spmm_extension.NeighborSampler(indptr, indices, seed=SEED)
 
-# Definiowanie loadera
-loader = DataLoader([data], batch_size=1024, shuffle=True)
+# Minibatche z węzłów treningowych: seedy + próbkowane sąsiedztwo (GraphSAGE).
+# batch_key = numer batcha, więc ten sam SEED daje te same podgrafy.
+train_idx = split_idx['train']
+generator = torch.Generator().manual_seed(SEED)
+train_idx = train_idx[torch.randperm(train_idx.numel(), generator=generator)]
 
 # Zapisywanie minibatchy
-for i, batch in enumerate(loader):
+for i, seeds in enumerate(train_idx.split(BATCH_SIZE)):
+    b_indptr, b_indices, nodes, edge_ids, hop_offsets = sampler.sample(seeds, FANOUTS, batch_key=i)
+    # lokalny graf: CSRGraph(indptr, indices), cechy x, wynik dla seedów to
+    # pierwsze batch_size wierszy
+    batch = {
+        'x': data.x[nodes],
+        'y': data.y[seeds].view(-1),
+        'indptr': b_indptr,
+        'indices': b_indices,
+        'nodes': nodes,
+        'hop_offsets': hop_offsets,
+    }
     torch.save(batch, f'batch_{i}.pt')
 
-print("Minibatche zostały zapisane.")
\ No newline at end of file
+print("Minibatche zostały zapisane.")
\ No newline at end of file
@@ -3,53 +3,13 @@
 #include <chrono>  // Dodaj chrono do pomiaru czasu
 #include <iomanip> // Dodaj iomanip do formatowania liczb
 #include <omp.h>   // Dodaj OpenMP
-#include <cstdlib> // Dodaj rand()
 
-// Struktura CSR
-struct CSRMatrix
-{
-    std::vector<int> row_ptr;
-    std::vector<int> col_idx;
-    std::vector<double> values;
-    int rows;
-    int cols;
-};
-
-// Funkcja do wykonywania SpMM z wykorzystaniem OpenMP
-std::vector<std::vector<double>> spmm(const CSRMatrix &A, const std::vector<std::vector<double>> &B)
-{
-    // Sprawdzenie wymiarów
-    if (A.cols != B.size())
-    {
-        throw std::invalid_argument("Dimensions of matrices are not compatible for multiplication.");
-    }
-
-    int rows = A.rows;
-    int cols = B[0].size();
-    std::vector<std::vector<double>> C(rows, std::vector<double>(cols, 0.0));
-
-    // Mnożenie równoległe
-#pragma omp parallel for
-    for (int i = 0; i < rows; ++i)
-    {
-        for (int j = A.row_ptr[i]; j < A.row_ptr[i + 1]; ++j)
-        {
-            int a_col = A.col_idx[j];
-            double a_val = A.values[j];
-
-            for (int k = 0; k < cols; ++k)
-            {
-#pragma omp atomic
-                C[i][k] += a_val * B[a_col][k];
-            }
-        }
-    }
-
-    return C;
-}
+#include <string>
+#include "spmm_omp.h"
+#include "graph_generator.h"
 
 // Funkcja do wyświetlania wyniku w formacie pełnej macierzy
-void printDense(const std::vector<std::vector<double>> &C)
+void printDense(const DenseMatrix<double> &C)
 {
     std::cout << "Dense matrix:" << std::endl;
     std::cout << std::fixed << std::setprecision(0); // Ustawienia formatowania
@@ -63,46 +23,42 @@ void printDense(const std::vector<std::vector<double>> &C)
     }
 }
 
-// Funkcja do generowania macierzy CSR o rozmiarze 100x100
-CSRMatrix generateRandomCSRMatrix(int size)
+// Użycie: OpenMPrandom [rows|coo] [graf] [liczba cech]
+//   tryb SpMM (domyślnie rows, patrz spmm_omp.h),
+//   graf z generatora (graph_generator.h, domyślnie rmat:14:16),
+//   liczba kolumn gęstej macierzy B (domyślnie 100).
+int main(int argc, char **argv)
 {
-    CSRMatrix mat;
-    mat.rows = mat.cols = size;
-
-    // Generowanie wierszy z losowymi wartościami w formacie CSR
-    mat.row_ptr.push_back(0); // Początek pierwszego wiersza
-    for (int i = 0; i < size; ++i)
-    {
-        int row_length = rand() % (size / 2); // Losowa liczba niezerowych elementów w wierszu
-        for (int j = 0; j < row_length; ++j)
-        {
-            mat.col_idx.push_back(rand() % size);     // Losowy indeks kolumny
-            mat.values.push_back((rand() % 100) + 1); // Losowa wartość
-        }
-        mat.row_ptr.push_back(mat.row_ptr.back() + row_length); // Aktualizacja wskaźnika końca wiersza
-    }
-
-    return mat;
-}
-
-int main()
-{
-    int size = 100; // Rozmiar macierzy 100x100
+    SpmmMode mode = parseSpmmMode(argc > 1 ? argv[1] : "rows");
+    std::string spec = argc > 2 ? argv[2] : "rmat:14:16";
+    int num_features = argc > 3 ? std::stoi(argv[3]) : 100;
 
     // Ustawienie liczby wątków na 4
     omp_set_num_threads(4);
 
-    // Generowanie losowych macierzy CSR i B
-    CSRMatrix A = generateRandomCSRMatrix(size);
+    // Generowanie grafu (posortowany CSR bez duplikatów) z wagami 1..100
+    auto gen_start = std::chrono::high_resolution_clock::now();
+    CSRMatrix A = toCsrMatrix(generateGraph(spec));
+    std::chrono::duration<double> gen_elapsed = std::chrono::high_resolution_clock::now() - gen_start;
+    std::cout << "Graf " << spec << ": " << A.rows << " wierzcholkow, " << A.col_idx.size() << " krawedzi, "
+              << "generowanie " << gen_elapsed.count() << " s" << std::endl;
 
-    // Tworzymy gęstą macierz B o wymiarach 100x100
-    std::vector<std::vector<double>> B(size, std::vector<double>(size, 1.0)); // Gęsta macierz 100x100 z wartościami 1
+    // Gęsta macierz B [liczba wierzchołków x liczba cech] z wartościami 1
+    DenseMatrix<double> B(A.rows, num_features, 1.0);
+
+    // Dla trybu coo lista wierszy krawędzi przygotowana przed pomiarem
+    std::vector<int> row_idx;
+    if (mode == SpmmMode::CooPrivate)
+    {
+        row_idx = csrRowIndices(A);
+    }
 
     // Pomiar czasu wykonania SpMM
     auto start = std::chrono::high_resolution_clock::now(); // Start czasu
 
     // Mnożenie A * B
-    std::vector<std::vector<double>> C = spmm(A, B);
+    DenseMatrix<double> C = mode == SpmmMode::Rows ? spmmRows(A, B)
+                                                   : spmmCooPrivate(A.rows, row_idx, A.col_idx, A.values, B);
 
     auto end = std::chrono::high_resolution_clock::now(); // Koniec czasu
 
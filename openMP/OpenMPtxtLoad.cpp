@@ -1,98 +1,92 @@
 #include <iostream>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <chrono>
 #include <omp.h>
 #include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include "spmm_omp.h"
+#include "graph_binary.h"
+#include "text_loader.h"
 
 using namespace std;
 
-// Funkcja do wczytania krawędzi grafu z pliku
-void loadEdges(const string& filename, vector<int>& row_idx, vector<int>& col_idx) {
-    ifstream file(filename);
-    int row, col;
-    while (file >> row >> col) {
-        row_idx.push_back(row);
-        col_idx.push_back(col);
-    }
-}
+// SpMM na grafie z pliku binarnego (graph_binary.h): CSR czytany wprost ze
+// zmapowanego pliku, liczba wierzchołków i cech z nagłówka.
+DenseMatrix<double> runBinary(const string& filename, SpmmMode mode, chrono::duration<double>& elapsed) {
+    MappedGraph graph(filename);
+    int num_nodes = static_cast<int>(graph.numNodes());
+    int num_features = static_cast<int>(graph.numFeatures());
+    DenseMatrix<double> B(num_nodes, num_features, 1.0);  // Tutaj zakładamy, że B to macierz 1
+    DenseMatrix<double> C;
 
-// Funkcja do wczytania cech wierzchołków z pliku
-void loadFeatures(const string& filename, vector<vector<double>>& features) {
-    ifstream file(filename);
-    string line;
-    while (getline(file, line)) {
-        stringstream ss(line);
-        vector<double> feature;
-        double val;
-        while (ss >> val) {
-            feature.push_back(val);
+    visitGraph(graph, [&](auto indptr, auto indices, auto values) {
+        // Dla trybu coo lista wierszy krawędzi przygotowana przed pomiarem
+        using Index = typename remove_const<typename remove_reference<decltype(indptr[0])>::type>::type;
+        vector<Index> row_idx;
+        if (mode == SpmmMode::CooPrivate) {
+            row_idx = csrRowIndices(num_nodes, indptr.data());
         }
-        features.push_back(feature);
-    }
-}
 
-// Funkcja do mnożenia macierzy rzadkiej (CSR) z gęstą
-void spmm(const vector<int>& row_idx, const vector<int>& col_idx, const vector<double>& values,
-          const vector<vector<double>>& B, vector<vector<double>>& C, int num_rows, int num_cols) {
-    #pragma omp parallel for
-    for (int i = 0; i < num_rows; ++i) {
-        for (size_t j = row_idx[i]; j < row_idx[i + 1]; ++j) {
-            int col = col_idx[j];
-            double val = values[j];
-            for (int k = 0; k < num_cols; ++k) {
-                #pragma omp atomic
-                C[i][k] += val * B[col][k];
-            }
+        auto start = chrono::high_resolution_clock::now();
+        if (mode == SpmmMode::Rows) {
+            C = spmmRows(num_nodes, indptr.data(), indices.data(), values.data(), B);
+        } else {
+            C = spmmCooPrivate(num_nodes, static_cast<long long>(indices.size()), row_idx.data(),
+                               indices.data(), values.data(), B);
         }
-    }
+        elapsed = chrono::high_resolution_clock::now() - start;
+    });
+
+    return C;
 }
 
-int main() {
-    // Załaduj dane z plików
+// SpMM na grafie z plików edges.txt i features.txt.
+DenseMatrix<double> runText(SpmmMode mode, chrono::duration<double>& elapsed) {
+    // Załaduj dane z plików (równolegle, patrz text_loader.h)
     vector<int> row_idx, col_idx;
-    loadEdges("edges.txt", row_idx, col_idx);
-
-    // Przekształć indeksy wierszy na CSR
-    int num_nodes = 2708;  // Liczba wierzchołków w Cora
-    vector<int> row_ptr(num_nodes + 1, 0);
-    vector<double> values(row_idx.size(), 1.0);  // Zwykle wartości w macierzy grafu są 1 w przypadku grafów nieskierowanych
-
-    // Zaktualizuj row_ptr
-    for (size_t i = 0; i < row_idx.size(); ++i) {
-        row_ptr[row_idx[i] + 1]++;
-    }
-
-    for (int i = 0; i < num_nodes; ++i) {
-        row_ptr[i + 1] += row_ptr[i];
-    }
+    loadEdgesParallel("edges.txt", row_idx, col_idx);
 
     // Załaduj cechy wierzchołków
-    vector<vector<double>> features;
-    loadFeatures("features.txt", features);
-    int num_features = features[0].size();  // Liczba cech dla każdego wierzchołka
+    DenseMatrix<double> features = loadFeaturesParallel("features.txt");
+    int num_nodes = features.rows();     // Liczba wierzchołków (wiersze features.txt)
+    int num_features = features.cols();  // Liczba cech dla każdego wierzchołka
 
-    // Stwórz gęstą macierz B
-    vector<vector<double>> B(num_nodes, vector<double>(num_features, 1.0));  // Tutaj zakładamy, że B to macierz 1
+    // Przekształć listę krawędzi na CSR (krawędzie nie muszą być posortowane po wierszu)
+    vector<double> values(row_idx.size(), 1.0);  // Zwykle wartości w macierzy grafu są 1 w przypadku grafów nieskierowanych
+    CSRMatrix A = cooToCsr(num_nodes, num_nodes, row_idx, col_idx, values);
 
-    // Przygotowanie macierzy wynikowej
-    vector<vector<double>> C(num_nodes, vector<double>(num_features, 0.0));
+    // Stwórz gęstą macierz B
+    DenseMatrix<double> B(num_nodes, num_features, 1.0);  // Tutaj zakładamy, że B to macierz 1
 
     // Pomiar czasu wykonania SpMM
     auto start = chrono::high_resolution_clock::now();
-    spmm(row_ptr, col_idx, values, B, C, num_nodes, num_features);
-    auto end = chrono::high_resolution_clock::now();
+    DenseMatrix<double> C = mode == SpmmMode::Rows ? spmmRows(A, B)
+                                                   : spmmCooPrivate(num_nodes, row_idx, col_idx, values, B);
+    elapsed = chrono::high_resolution_clock::now() - start;
+    return C;
+}
+
+// Użycie: OpenMPtxtLoad [rows|coo] [graph.bin]
+//   tryb SpMM (domyślnie rows, patrz spmm_omp.h); z plikiem .bin graf jest
+//   mapowany z pliku binarnego zapisanego przez torch_load_txt.py, bez niego
+//   czytane są edges.txt i features.txt
+// Kompilacja: g++ -std=c++17 -O2 -fopenmp OpenMPtxtLoad.cpp
+int main(int argc, char** argv) {
+    SpmmMode mode = parseSpmmMode(argc > 1 ? argv[1] : "rows");
+
+    chrono::duration<double> elapsed;
+    DenseMatrix<double> C = argc > 2 ? runBinary(argv[2], mode, elapsed) : runText(mode, elapsed);
 
     // Czas wykonania
-    chrono::duration<double> elapsed = end - start;
     cout << fixed << setprecision(6);
     cout << "Czas wykonania SpMM: " << elapsed.count() << " sekund" << endl;
 
     // // Wyświetlenie wyników
     // cout << "Pierwsze 5 wierszy macierzy C:" << endl;
     // for (int i = 0; i < 5; ++i) {
-    //     for (int j = 0; j < num_features; ++j) {
+    //     for (int j = 0; j < C.cols(); ++j) {
     //         cout << C[i][j] << " ";
     //     }
     //     cout << endl;
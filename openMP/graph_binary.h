@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "../dense_matrix.h"
+#include "mapped_file.h"
+
+// Binarny format grafu (zapisywany przez torch_load_txt.py):
+//
+//   [nagłówek GraphFileHeader][indptr][indices][values][features]
+//
+// indptr ma num_nodes+1 elementów, indices/values po num_edges (CSR
+// posortowany po wierszach), features to blok num_nodes x num_features
+// wierszami. Każda sekcja zaczyna się na granicy 64 bajtów, a jej położenie
+// zapisane jest w nagłówku. Szerokość indeksów (4/8 bajtów) i typ wartości
+// (float32/float64, wspólny dla values i features) też są w nagłówku.
+//
+// MappedGraph mapuje plik do pamięci (MappedFile) i zwraca widoki na sekcje
+// bez kopiowania.
+
+constexpr char kGraphMagic[8] = {'P', '3', '3', '0', 'G', 'R', 'P', 'H'};
+constexpr uint32_t kGraphVersion = 1;
+constexpr uint64_t kGraphAlignment = 64;
+
+enum class GraphDtype : uint32_t {
+    Float32 = 0,
+    Float64 = 1
+};
+
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;       // GraphDtype
+    uint32_t index_width; // 4 lub 8
+    uint32_t reserved;
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t num_features;
+    uint64_t indptr_offset;
+    uint64_t indices_offset;
+    uint64_t values_offset;
+    uint64_t features_offset;
+};
+static_assert(sizeof(GraphFileHeader) == 80, "GraphFileHeader layout must match torch_load_txt.py");
+
+class MappedGraph {
+public:
+    explicit MappedGraph(const std::string& filename) : file_(filename) {
+        validate(filename);
+    }
+
+    const GraphFileHeader& header() const { return *reinterpret_cast<const GraphFileHeader*>(file_.data()); }
+    int64_t numNodes() const { return static_cast<int64_t>(header().num_nodes); }
+    int64_t numEdges() const { return static_cast<int64_t>(header().num_edges); }
+    int64_t numFeatures() const { return static_cast<int64_t>(header().num_features); }
+    GraphDtype dtype() const { return static_cast<GraphDtype>(header().dtype); }
+    uint32_t indexWidth() const { return header().index_width; }
+
+    // Widoki na sekcje; Index/Value muszą zgadzać się z nagłówkiem.
+    template <typename Index>
+    RowSpan<const Index> indptr() const {
+        checkIndex<Index>();
+        return section<Index>(header().indptr_offset, header().num_nodes + 1);
+    }
+
+    template <typename Index>
+    RowSpan<const Index> indices() const {
+        checkIndex<Index>();
+        return section<Index>(header().indices_offset, header().num_edges);
+    }
+
+    template <typename Value>
+    RowSpan<const Value> values() const {
+        checkValue<Value>();
+        return section<Value>(header().values_offset, header().num_edges);
+    }
+
+    // Cechy wierzchołka i (num_features wartości)
+    template <typename Value>
+    RowSpan<const Value> features(int64_t i) const {
+        checkValue<Value>();
+        const Value* block = reinterpret_cast<const Value*>(file_.data() + header().features_offset);
+        return RowSpan<const Value>(block + size_t(i) * header().num_features, header().num_features);
+    }
+
+private:
+    void validate(const std::string& filename) const {
+        if (file_.size() < sizeof(GraphFileHeader) || std::memcmp(header().magic, kGraphMagic, sizeof(kGraphMagic)) != 0) {
+            throw std::runtime_error(filename + " is not a graph binary file.");
+        }
+        const GraphFileHeader& h = header();
+        if (h.version != kGraphVersion) {
+            throw std::runtime_error("Unsupported graph file version in " + filename);
+        }
+        if (h.index_width != 4 && h.index_width != 8) {
+            throw std::runtime_error("Invalid index width in " + filename);
+        }
+        if (h.dtype != static_cast<uint32_t>(GraphDtype::Float32) && h.dtype != static_cast<uint32_t>(GraphDtype::Float64)) {
+            throw std::runtime_error("Invalid value dtype in " + filename);
+        }
+
+        const uint64_t value_width = h.dtype == static_cast<uint32_t>(GraphDtype::Float32) ? 4 : 8;
+        checkSection(filename, h.indptr_offset, (h.num_nodes + 1) * h.index_width);
+        checkSection(filename, h.indices_offset, h.num_edges * h.index_width);
+        checkSection(filename, h.values_offset, h.num_edges * value_width);
+        checkSection(filename, h.features_offset, h.num_nodes * h.num_features * value_width);
+    }
+
+    void checkSection(const std::string& filename, uint64_t offset, uint64_t bytes) const {
+        if (offset % kGraphAlignment != 0 || offset > file_.size() || bytes > file_.size() - offset) {
+            throw std::runtime_error("Corrupted section table in " + filename);
+        }
+    }
+
+    template <typename Index>
+    void checkIndex() const {
+        if (sizeof(Index) != indexWidth()) {
+            throw std::invalid_argument("Requested index type does not match graph file index width.");
+        }
+    }
+
+    template <typename Value>
+    void checkValue() const {
+        if (sizeof(Value) != (dtype() == GraphDtype::Float32 ? 4u : 8u)) {
+            throw std::invalid_argument("Requested value type does not match graph file dtype.");
+        }
+    }
+
+    template <typename T>
+    RowSpan<const T> section(uint64_t offset, uint64_t count) const {
+        return RowSpan<const T>(reinterpret_cast<const T*>(file_.data() + offset), count);
+    }
+
+    MappedFile file_;
+};
+
+// Wywołuje fn(indptr, indices, values) z widokami o typach z nagłówka.
+template <typename Fn>
+void visitGraph(const MappedGraph& g, Fn&& fn) {
+    const bool wide = g.indexWidth() == 8;
+    const bool f64 = g.dtype() == GraphDtype::Float64;
+    if (wide && f64) {
+        fn(g.indptr<int64_t>(), g.indices<int64_t>(), g.values<double>());
+    } else if (wide) {
+        fn(g.indptr<int64_t>(), g.indices<int64_t>(), g.values<float>());
+    } else if (f64) {
+        fn(g.indptr<int32_t>(), g.indices<int32_t>(), g.values<double>());
+    } else {
+        fn(g.indptr<int32_t>(), g.indices<int32_t>(), g.values<float>());
+    }
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../csr_matrix.h"
+
+// Równoległy generator grafów syntetycznych, od razu w CSR (wiersze
+// posortowane, bez duplikatów i pętli własnych). Modele:
+//
+//   R-MAT (Kronecker) - 2^scale wierzchołków, edge_factor * 2^scale losowań
+//                       krawędzi; każda krawędź to scale wyborów ćwiartki
+//                       macierzy z prawdopodobieństwami a, b, c, d = 1-a-b-c.
+//                       Skośność stopni ustawia się przez a (Graph500:
+//                       a=0.57, b=c=0.19; a=b=c=0.25 to graf jednorodny).
+//   Barabási-Albert   - n wierzchołków, każdy nowy dołącza m krawędzi
+//                       z prawdopodobieństwem proporcjonalnym do stopnia
+//                       (rozkład potęgowy ~k^-3). Liczony równolegle metodą
+//                       Sandersa i Schulza: cel krawędzi e to losowa wcześniejsza
+//                       pozycja listy krawędzi, a cel pozycji "docelowej"
+//                       rozwijany jest rekurencyjnie tym samym losowaniem.
+//   Erdős-Rényi       - G(n, p) z p = avg_degree / n, generowany wierszami
+//                       przez przeskoki geometryczne (koszt ~ liczba krawędzi).
+//
+// Losowość jest "licznikowa": każda wartość to funkcja (seed, strumień,
+// licznik), bez stanu współdzielonego między wątkami. Graf zależy więc tylko
+// od parametrów i seed, a nie od liczby wątków ani przeplotu.
+//
+// Budowa CSR (buildCsr) jest dwuprzebiegowa: najpierw zliczenie krawędzi na
+// wiersz, potem ponowne wygenerowanie tych samych krawędzi prosto na ich
+// miejsca - lista COO nigdy nie jest trzymana w pamięci. Szczyt pamięci to
+// dwa bufory indeksów po M elementów (przed i po usunięciu duplikatów),
+// czyli przy Index = int32 ok. 8 B na losowaną krawędź.
+
+namespace graph_gen {
+
+// splitmix64 (finalizer) - dobra dyfuzja bitów dla kolejnych liczników
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Generator licznikowy: strumień (np. numer krawędzi albo wiersza) i licznik
+// wewnątrz strumienia wyznaczają wynik jednoznacznie.
+class CounterRng {
+public:
+    CounterRng(uint64_t seed, uint64_t stream) : key_(mix64(seed ^ mix64(stream))) {}
+
+    uint64_t bits(uint64_t counter) const { return mix64(key_ + counter * 0xd1b54a32d192ed03ULL); }
+
+    // [0, 1)
+    double uniform(uint64_t counter) const { return double(bits(counter) >> 11) * (1.0 / 9007199254740992.0); }
+
+    // [0, n), mnożenie zamiast modulo (Lemire)
+    uint64_t below(uint64_t counter, uint64_t n) const {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(bits(counter)) * n) >> 64);
+#else
+        return bits(counter) % n;
+#endif
+    }
+
+private:
+    uint64_t key_;
+};
+
+} // namespace graph_gen
+
+// Wynik generatora: CSR bez wag. indptr jest int64 (liczba krawędzi może
+// przekroczyć 2^31), Index - typ indeksów kolumn.
+template <typename Index = int32_t>
+struct GeneratedCsr {
+    int64_t num_nodes = 0;
+    std::vector<int64_t> indptr;
+    std::vector<Index> indices;
+
+    int64_t numEdges() const { return static_cast<int64_t>(indices.size()); }
+};
+
+// Funkcja: buildCsr
+// emit(item, out) wywołuje out(row, col) dla każdej krawędzi elementu item
+// (item w [0, num_items)); musi dawać te same krawędzie przy każdym wywołaniu.
+// Wynik: wiersze posortowane, bez duplikatów, bez pętli (drop_self_loops).
+template <typename Index, typename Emit>
+GeneratedCsr<Index> buildCsr(int64_t num_nodes, int64_t num_items, const Emit& emit, bool drop_self_loops = true) {
+    if (num_nodes > static_cast<int64_t>(std::numeric_limits<Index>::max())) {
+        throw std::overflow_error("Too many nodes for the index type.");
+    }
+
+    // 1. zliczenie krawędzi na wiersz
+    std::vector<int64_t> fill(num_nodes + 1, 0);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (int64_t item = 0; item < num_items; ++item) {
+        emit(item, [&](int64_t row, int64_t) {
+#pragma omp atomic
+            fill[row + 1]++;
+        });
+    }
+    for (int64_t i = 0; i < num_nodes; ++i) {
+        fill[i + 1] += fill[i];
+    }
+    std::vector<int64_t> raw_ptr(fill);
+
+    // 2. ponowne wygenerowanie i rozrzucenie kolumn na miejsca wierszy
+    std::vector<Index> raw(raw_ptr[num_nodes]);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (int64_t item = 0; item < num_items; ++item) {
+        emit(item, [&](int64_t row, int64_t col) {
+            int64_t pos;
+#pragma omp atomic capture
+            pos = fill[row]++;
+            raw[pos] = static_cast<Index>(col);
+        });
+    }
+
+    // 3. sortowanie i usuwanie duplikatów w każdym wierszu (kolejność wewnątrz
+    //    wiersza po kroku 2 zależy od przeplotu, po sortowaniu już nie)
+    GeneratedCsr<Index> g;
+    g.num_nodes = num_nodes;
+    g.indptr.assign(num_nodes + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t row = 0; row < num_nodes; ++row) {
+        auto begin = raw.begin() + raw_ptr[row];
+        auto end = raw.begin() + raw_ptr[row + 1];
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+        if (drop_self_loops) {
+            end = std::remove(begin, end, static_cast<Index>(row));
+        }
+        g.indptr[row + 1] = end - begin;
+    }
+    for (int64_t i = 0; i < num_nodes; ++i) {
+        g.indptr[i + 1] += g.indptr[i];
+    }
+
+    // 4. zwarty CSR
+    g.indices.resize(g.indptr[num_nodes]);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t row = 0; row < num_nodes; ++row) {
+        std::copy(raw.begin() + raw_ptr[row], raw.begin() + raw_ptr[row] + (g.indptr[row + 1] - g.indptr[row]),
+                  g.indices.begin() + g.indptr[row]);
+    }
+    return g;
+}
+
+struct RmatParams {
+    int scale = 16;          // 2^scale wierzchołków
+    double edge_factor = 16; // losowań krawędzi na wierzchołek
+    double a = 0.57;
+    double b = 0.19;
+    double c = 0.19;
+    bool symmetric = false;  // dodaj krawędzie odwrotne
+    bool scramble = true;    // losowa permutacja numerów (huby nie są w wierszu 0)
+    uint64_t seed = 1;
+};
+
+// Funkcja: generateRmat
+// Graf R-MAT. scramble przenumerowuje wierzchołki bijekcją na [0, 2^scale),
+// bo bez niej huby mają najmniejsze numery, co sztucznie poprawia lokalność.
+template <typename Index = int32_t>
+GeneratedCsr<Index> generateRmat(const RmatParams& p) {
+    if (p.scale < 1 || p.scale > 40) {
+        throw std::invalid_argument("R-MAT scale must be in [1, 40].");
+    }
+    if (p.a < 0 || p.b < 0 || p.c < 0 || p.a + p.b + p.c > 1.0) {
+        throw std::invalid_argument("R-MAT probabilities must satisfy a, b, c >= 0 and a + b + c <= 1.");
+    }
+
+    const int64_t n = int64_t(1) << p.scale;
+    const int64_t m = static_cast<int64_t>(p.edge_factor * double(n));
+    const uint64_t mask = uint64_t(n) - 1;
+    const uint64_t odd1 = graph_gen::mix64(p.seed ^ 0x5eed) | 1;
+    const uint64_t odd2 = graph_gen::mix64(p.seed ^ 0xfeed) | 1;
+    const int shift = (p.scale + 1) / 2;
+    // progi ćwiartek z dokładnością 2^-16 - jedno 64-bitowe losowanie na 4 poziomy
+    const uint64_t t_a = static_cast<uint64_t>(std::llround(p.a * 65536.0));
+    const uint64_t t_ab = static_cast<uint64_t>(std::llround((p.a + p.b) * 65536.0));
+    const uint64_t t_abc = static_cast<uint64_t>(std::llround((p.a + p.b + p.c) * 65536.0));
+
+    // mnożenie przez liczbę nieparzystą i xorshift są bijekcjami modulo 2^scale
+    auto scramble = [&](uint64_t v) {
+        if (!p.scramble) {
+            return v;
+        }
+        v = (v * odd1) & mask;
+        v ^= v >> shift;
+        return (v * odd2) & mask;
+    };
+
+    auto emit = [&](int64_t e, auto&& out) {
+        graph_gen::CounterRng rng(p.seed, static_cast<uint64_t>(e));
+        uint64_t row = 0, col = 0;
+        uint64_t bits = 0;
+        for (int level = 0; level < p.scale; ++level) {
+            if (level % 4 == 0) {
+                bits = rng.bits(level / 4);
+            }
+            // ćwiartka bez skoków warunkowych: a -> (0,0), b -> (0,1), c -> (1,0), d -> (1,1)
+            const uint64_t u = bits & 0xffff;
+            bits >>= 16;
+            const uint64_t right = (u >= t_a) & (u < t_ab);
+            const uint64_t down = u >= t_ab;
+            const uint64_t both = u >= t_abc;
+            row = (row << 1) | down;
+            col = (col << 1) | right | both;
+        }
+        row = scramble(row);
+        col = scramble(col);
+        out(static_cast<int64_t>(row), static_cast<int64_t>(col));
+        if (p.symmetric) {
+            out(static_cast<int64_t>(col), static_cast<int64_t>(row));
+        }
+    };
+    return buildCsr<Index>(n, m, emit);
+}
+
+struct BarabasiAlbertParams {
+    int64_t num_nodes = 1 << 16;
+    int64_t edges_per_node = 8; // m
+    uint64_t seed = 1;
+};
+
+// Funkcja: generateBarabasiAlbert
+// Graf nieskierowany (CSR symetryczny). Lista krawędzi ma pozycje 2e (źródło,
+// wierzchołek e / m) i 2e+1 (cel). Cel krawędzi e to wartość losowej pozycji
+// r < 2e+1: parzysta - to źródło krawędzi r/2, nieparzysta - cel krawędzi r/2,
+// rozwijany tak samo. Wybór pozycji z listy krawędzi to wybór wierzchołka
+// proporcjonalnie do stopnia, a każda krawędź jest liczona niezależnie.
+// Duplikaty i pętle są usuwane, więc stopnie wychodzą nieco mniejsze niż 2m.
+template <typename Index = int32_t>
+GeneratedCsr<Index> generateBarabasiAlbert(const BarabasiAlbertParams& p) {
+    if (p.num_nodes < 1 || p.edges_per_node < 1) {
+        throw std::invalid_argument("Barabasi-Albert needs num_nodes >= 1 and edges_per_node >= 1.");
+    }
+    const int64_t m = p.edges_per_node;
+
+    auto emit = [&](int64_t e, auto&& out) {
+        uint64_t pos = 2 * uint64_t(e) + 1;
+        while (pos & 1) {
+            const uint64_t edge = pos >> 1;
+            pos = graph_gen::CounterRng(p.seed, edge).below(0, 2 * edge + 1);
+        }
+        const int64_t source = e / m;
+        const int64_t target = static_cast<int64_t>(pos >> 1) / m;
+        out(source, target);
+        out(target, source);
+    };
+    return buildCsr<Index>(p.num_nodes, p.num_nodes * m, emit);
+}
+
+struct ErdosRenyiParams {
+    int64_t num_nodes = 1 << 16;
+    double avg_degree = 16;
+    bool symmetric = true;
+    uint64_t seed = 1;
+};
+
+// Funkcja: generateErdosRenyi
+// G(n, p): każda para jest krawędzią niezależnie z prawdopodobieństwem p.
+// Wiersz r losuje kolejne kolumny przeskokami o długości z rozkładu
+// geometrycznego (Batagelj-Brandes), więc nie przegląda wszystkich n kolumn.
+// symmetric: losowane są tylko kolumny > r i dodawane obie krawędzie.
+template <typename Index = int32_t>
+GeneratedCsr<Index> generateErdosRenyi(const ErdosRenyiParams& p) {
+    if (p.num_nodes < 1 || p.avg_degree < 0) {
+        throw std::invalid_argument("Erdos-Renyi needs num_nodes >= 1 and avg_degree >= 0.");
+    }
+    const int64_t n = p.num_nodes;
+    const double prob = std::min(1.0, p.avg_degree / double(std::max<int64_t>(n - 1, 1)));
+
+    auto emit = [&](int64_t row, auto&& out) {
+        if (prob <= 0.0) {
+            return;
+        }
+        graph_gen::CounterRng rng(p.seed, static_cast<uint64_t>(row));
+        const double log_q = std::log1p(-prob);
+        int64_t col = p.symmetric ? row : -1;
+        for (uint64_t k = 0;; ++k) {
+            // przeskok ~ Geom(prob): liczba pominiętych kolumn przed następną krawędzią
+            const double skip = prob >= 1.0 ? 0.0 : std::floor(std::log1p(-rng.uniform(k)) / log_q);
+            if (skip >= double(n)) {
+                break;
+            }
+            col += 1 + static_cast<int64_t>(skip);
+            if (col >= n) {
+                break;
+            }
+            if (col == row) {
+                continue;
+            }
+            out(row, col);
+            if (p.symmetric) {
+                out(col, row);
+            }
+        }
+    };
+    return buildCsr<Index>(n, n, emit);
+}
+
+namespace graph_gen {
+
+// Pola opisu grafu. Całe pole musi być liczbą - "4x" albo "" to błąd,
+// a nie cicho ucięte 4. Liczby całkowite mogą mieć przyrostek K/M/G
+// (10^3/10^6/10^9), np. er:4M:24.
+inline int64_t specCount(const std::string& field, const std::string& spec) {
+    int64_t multiplier = 1;
+    std::string digits = field;
+    if (!digits.empty()) {
+        switch (digits.back()) {
+        case 'K': case 'k': multiplier = 1000LL; break;
+        case 'M': case 'm': multiplier = 1000000LL; break;
+        case 'G': case 'g': multiplier = 1000000000LL; break;
+        }
+        if (multiplier != 1) {
+            digits.pop_back();
+        }
+    }
+    size_t pos = 0;
+    long long value = 0;
+    try {
+        value = std::stoll(digits, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (digits.empty() || pos != digits.size()) {
+        throw std::invalid_argument("Invalid integer '" + field + "' in graph spec '" + spec + "'.");
+    }
+    if (value > std::numeric_limits<int64_t>::max() / multiplier || value < std::numeric_limits<int64_t>::min() / multiplier) {
+        throw std::invalid_argument("Integer '" + field + "' out of range in graph spec '" + spec + "'.");
+    }
+    return value * multiplier;
+}
+
+inline double specReal(const std::string& field, const std::string& spec) {
+    size_t pos = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(field, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (field.empty() || pos != field.size()) {
+        throw std::invalid_argument("Invalid number '" + field + "' in graph spec '" + spec + "'.");
+    }
+    return value;
+}
+
+} // namespace graph_gen
+
+// Graf z opisu tekstowego (jak --graph w benchmarku):
+//   rmat:scale:edge_factor[:a:b:c]  - R-MAT, skierowany, z przenumerowaniem,
+//   ba:n:m                          - Barabási-Albert,
+//   er:n:avg_degree                 - Erdős-Rényi, nieskierowany.
+// n i m mogą mieć przyrostek K/M/G (graph_gen::specCount).
+inline bool isGeneratorSpec(const std::string& spec) {
+    const std::string model = spec.substr(0, spec.find(':'));
+    return model == "rmat" || model == "ba" || model == "er";
+}
+
+template <typename Index = int32_t>
+GeneratedCsr<Index> generateGraph(const std::string& spec, uint64_t seed = 1) {
+    std::vector<std::string> parts;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ':')) {
+        parts.push_back(item);
+    }
+    if (parts.empty()) {
+        parts.push_back("");
+    }
+
+    if (parts[0] == "rmat" && (parts.size() == 3 || parts.size() == 6)) {
+        RmatParams p;
+        p.scale = static_cast<int>(graph_gen::specCount(parts[1], spec));
+        p.edge_factor = graph_gen::specReal(parts[2], spec);
+        if (parts.size() == 6) {
+            p.a = graph_gen::specReal(parts[3], spec);
+            p.b = graph_gen::specReal(parts[4], spec);
+            p.c = graph_gen::specReal(parts[5], spec);
+        }
+        p.seed = seed;
+        return generateRmat<Index>(p);
+    }
+    if (parts[0] == "ba" && parts.size() == 3) {
+        BarabasiAlbertParams p;
+        p.num_nodes = graph_gen::specCount(parts[1], spec);
+        p.edges_per_node = graph_gen::specCount(parts[2], spec);
+        p.seed = seed;
+        return generateBarabasiAlbert<Index>(p);
+    }
+    if (parts[0] == "er" && parts.size() == 3) {
+        ErdosRenyiParams p;
+        p.num_nodes = graph_gen::specCount(parts[1], spec);
+        p.avg_degree = graph_gen::specReal(parts[2], spec);
+        p.seed = seed;
+        return generateErdosRenyi<Index>(p);
+    }
+    throw std::invalid_argument("Unknown graph spec '" + spec +
+                                "' (expected rmat:scale:edge_factor[:a:b:c], ba:n:m or er:n:avg_degree).");
+}
+
+// Wygenerowany graf jako CSRMatrix (csr_matrix.h) z wagami całkowitymi
+// 1..100 wyznaczonymi przez (seed, numer krawędzi), jak dawniej w
+// generateRandomCSRMatrix.
+inline CSRMatrix toCsrMatrix(const GeneratedCsr<int32_t>& g, uint64_t seed = 1) {
+    if (g.numEdges() > static_cast<int64_t>(INT_MAX)) {
+        throw std::overflow_error("Too many edges for int indices.");
+    }
+    CSRMatrix A;
+    A.rows = A.cols = static_cast<int>(g.num_nodes);
+    A.row_ptr.assign(g.indptr.begin(), g.indptr.end());
+    A.col_idx = g.indices;
+    A.values.resize(g.indices.size());
+    graph_gen::CounterRng rng(seed, 0x76a1);
+#pragma omp parallel for schedule(static)
+    for (int64_t e = 0; e < g.numEdges(); ++e) {
+        A.values[e] = double(rng.below(e, 100) + 1);
+    }
+    return A;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Plik zmapowany do pamięci tylko do odczytu (mmap / MapViewOfFile).
+// Strony są doczytywane z dysku przy pierwszym dostępie, bez kopiowania
+// do bufora. Pusty plik daje data() == nullptr i size() == 0.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+        file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Cannot open " + filename);
+        }
+        LARGE_INTEGER size;
+        GetFileSizeEx(file_, &size);
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ == 0) {
+            return;
+        }
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        base_ = mapping_ ? static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + filename);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat " + filename);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) {
+            close(fd);
+            return;
+        }
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        base_ = p == MAP_FAILED ? nullptr : static_cast<const char*>(p);
+#endif
+        if (!base_) {
+            unmap();
+            throw std::runtime_error("Cannot map " + filename);
+        }
+    }
+
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base_; }
+    size_t size() const { return size_; }
+
+private:
+    void unmap() {
+#ifdef _WIN32
+        if (base_) UnmapViewOfFile(base_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (base_) munmap(const_cast<char*>(base_), size_);
+#endif
+        base_ = nullptr;
+    }
+
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
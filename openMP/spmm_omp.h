@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "../csr_matrix.h"
+#include "../dense_matrix.h"
+
+// Dwa tryby równoległego SpMM (rzadka A x gęsta B), wybierane w sterowniku:
+//
+// "rows" - wiersze A podzielone między wątki. Każdy wiersz C ma dokładnie
+//          jednego właściciela, więc akumulacja jest zwykłym += bez atomic.
+// "coo"  - krawędzie (COO) podzielone między wątki. Różne wątki mogą pisać do
+//          tego samego wiersza C, więc każdy wątek ma prywatny bufor wyniku,
+//          a bufory są na końcu sumowane drzewiasto (log2(liczba wątków)
+//          rund, w każdej rundzie wiersze dzielone między wszystkie wątki).
+
+enum class SpmmMode {
+    Rows,
+    CooPrivate
+};
+
+inline SpmmMode parseSpmmMode(const std::string& name) {
+    if (name == "rows") {
+        return SpmmMode::Rows;
+    }
+    if (name == "coo") {
+        return SpmmMode::CooPrivate;
+    }
+    throw std::invalid_argument("Unknown SpMM mode '" + name + "' (expected rows or coo).");
+}
+
+// Jądra przyjmują surowe wskaźniki (Index = int32/int64, Value = float/double),
+// więc działają zarówno na CSRMatrix, jak i na widokach zmapowanego pliku
+// (graph_binary.h) bez kopiowania.
+
+// Tryb "rows": C = A * B, równolegle po wierszach.
+template <typename Index, typename Value>
+DenseMatrix<double> spmmRows(int rows, const Index* row_ptr, const Index* col_idx, const Value* values,
+                             const DenseMatrix<double>& B) {
+    const int cols = B.cols();
+    DenseMatrix<double> C(rows, cols, 0.0);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < rows; ++i) {
+        double* c_row = C.row(i);
+        for (Index j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+            const double a_val = values[j];
+            const double* b_row = B.row(static_cast<int>(col_idx[j]));
+#pragma omp simd
+            for (int k = 0; k < cols; ++k) {
+                c_row[k] += a_val * b_row[k];
+            }
+        }
+    }
+
+    return C;
+}
+
+inline DenseMatrix<double> spmmRows(const CSRMatrix& A, const DenseMatrix<double>& B) {
+    if (A.cols != B.rows()) {
+        throw std::invalid_argument("Dimensions of matrices are not compatible for multiplication.");
+    }
+    return spmmRows(A.rows, A.row_ptr.data(), A.col_idx.data(), A.values.data(), B);
+}
+
+// Tryb "coo": C = A * B dla A w formacie COO (row_idx, col_idx, values),
+// równolegle po krawędziach, z prywatnymi buforami zamiast atomic.
+template <typename Index, typename Value>
+DenseMatrix<double> spmmCooPrivate(int rows, long long nnz, const Index* row_idx, const Index* col_idx,
+                                   const Value* values, const DenseMatrix<double>& B) {
+    const int cols = B.cols();
+    std::vector<DenseMatrix<double>> partial(omp_get_max_threads());
+
+#pragma omp parallel
+    {
+        const int num_threads = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        partial[t] = DenseMatrix<double>(rows, cols, 0.0);
+        DenseMatrix<double>& C = partial[t];
+
+#pragma omp for schedule(static)
+        for (long long e = 0; e < nnz; ++e) {
+            const double val = values[e];
+            const double* b_row = B.row(static_cast<int>(col_idx[e]));
+            double* c_row = C.row(static_cast<int>(row_idx[e]));
+#pragma omp simd
+            for (int k = 0; k < cols; ++k) {
+                c_row[k] += val * b_row[k];
+            }
+        }
+
+        // Redukcja drzewiasta: w rundzie step bufor t += bufor t + step
+        for (int step = 1; step < num_threads; step *= 2) {
+#pragma omp for schedule(static)
+            for (int i = 0; i < rows; ++i) {
+                for (int dst = 0; dst + step < num_threads; dst += 2 * step) {
+                    double* out = partial[dst].row(i);
+                    const double* in = partial[dst + step].row(i);
+#pragma omp simd
+                    for (int k = 0; k < cols; ++k) {
+                        out[k] += in[k];
+                    }
+                }
+            }
+        }
+    }
+
+    return std::move(partial[0]);
+}
+
+inline DenseMatrix<double> spmmCooPrivate(int rows,
+                                          const std::vector<int>& row_idx,
+                                          const std::vector<int>& col_idx,
+                                          const std::vector<double>& values,
+                                          const DenseMatrix<double>& B) {
+    if (row_idx.size() != col_idx.size() || row_idx.size() != values.size()) {
+        throw std::invalid_argument("COO arrays must have the same length.");
+    }
+    return spmmCooPrivate(rows, static_cast<long long>(row_idx.size()), row_idx.data(), col_idx.data(),
+                          values.data(), B);
+}
+
+// Rozwinięcie CSR do listy wierszy krawędzi (COO) dla trybu "coo".
+template <typename Index>
+std::vector<Index> csrRowIndices(int rows, const Index* row_ptr) {
+    std::vector<Index> row_idx(row_ptr[rows]);
+    for (int i = 0; i < rows; ++i) {
+        std::fill(row_idx.begin() + row_ptr[i], row_idx.begin() + row_ptr[i + 1], static_cast<Index>(i));
+    }
+    return row_idx;
+}
+
+inline std::vector<int> csrRowIndices(const CSRMatrix& A) {
+    return csrRowIndices(A.rows, A.row_ptr.data());
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "../dense_matrix.h"
+#include "mapped_file.h"
+
+// Równoległe wczytywanie plików tekstowych (edges.txt, features.txt).
+//
+// Plik jest mapowany do pamięci i dzielony na fragmenty (po jednym na wątek)
+// wyrównane do granic linii. Dwa przejścia:
+//   1. każdy wątek liczy linie w swoim fragmencie, suma prefiksowa daje
+//      numer pierwszej linii fragmentu i rozmiar wyniku,
+//   2. bufory wyniku są alokowane raz, a każdy wątek parsuje swoje linie
+//      (std::from_chars) wprost w docelowe miejsce.
+// Puste linie (same białe znaki) są pomijane w obu przejściach. Wymaga C++17.
+
+namespace text_loader {
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Podział [0, size) na num_chunks fragmentów zaczynających się od nowej linii.
+inline std::vector<size_t> lineAlignedChunks(const char* data, size_t size, int num_chunks) {
+    std::vector<size_t> bounds(num_chunks + 1);
+    bounds[0] = 0;
+    for (int t = 1; t < num_chunks; ++t) {
+        size_t pos = std::max(bounds[t - 1], size * t / num_chunks);
+        while (pos < size && pos > 0 && data[pos - 1] != '\n') {
+            ++pos;
+        }
+        bounds[t] = pos;
+    }
+    bounds[num_chunks] = size;
+    return bounds;
+}
+
+// Wywołuje fn(line_begin, line_end) dla każdej niepustej linii w [begin, end).
+template <typename Fn>
+void forEachLine(const char* begin, const char* end, Fn&& fn) {
+    while (begin < end) {
+        const char* line_end = std::find(begin, end, '\n');
+        const char* p = begin;
+        while (p < line_end && isBlank(*p)) {
+            ++p;
+        }
+        if (p < line_end) {
+            fn(p, line_end);
+        }
+        begin = line_end + (line_end < end ? 1 : 0);
+    }
+}
+
+// Parsuje kolejną liczbę z [p, end), pomijając wiodące białe znaki.
+// Zwraca false, gdy w linii nie ma już liczb.
+template <typename T>
+bool parseNext(const char*& p, const char* end, T& value) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+    if (*p == '+') {
+        ++p; // from_chars nie akceptuje jawnego '+'
+    }
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("Malformed number in text input.");
+    }
+    p = result.ptr;
+    return true;
+}
+
+// Przejście 1: liczba linii w każdym fragmencie i numer pierwszej linii
+// fragmentu (line_start[t]); line_start[num_chunks] to liczba wszystkich linii.
+inline std::vector<int64_t> countLines(const char* data, const std::vector<size_t>& bounds) {
+    const int num_chunks = static_cast<int>(bounds.size()) - 1;
+    std::vector<int64_t> line_start(num_chunks + 1, 0);
+
+#pragma omp parallel for schedule(static, 1)
+    for (int t = 0; t < num_chunks; ++t) {
+        int64_t count = 0;
+        forEachLine(data + bounds[t], data + bounds[t + 1], [&](const char*, const char*) { ++count; });
+        line_start[t + 1] = count;
+    }
+
+    for (int t = 0; t < num_chunks; ++t) {
+        line_start[t + 1] += line_start[t];
+    }
+    return line_start;
+}
+
+// Przejście 2: fn(line, line_begin, line_end) dla każdej linii, równolegle po
+// fragmentach. Wyjątek z dowolnego wątku jest przekazywany dalej.
+template <typename Fn>
+void parseLines(const char* data, const std::vector<size_t>& bounds, const std::vector<int64_t>& line_start, Fn&& fn) {
+    const int num_chunks = static_cast<int>(bounds.size()) - 1;
+    std::atomic<bool> failed(false);
+    std::string error;
+
+#pragma omp parallel for schedule(static, 1)
+    for (int t = 0; t < num_chunks; ++t) {
+        try {
+            int64_t line = line_start[t];
+            forEachLine(data + bounds[t], data + bounds[t + 1], [&](const char* begin, const char* end) {
+                fn(line++, begin, end);
+            });
+        } catch (const std::exception& e) {
+            if (!failed.exchange(true)) {
+                error = e.what();
+            }
+        }
+    }
+
+    if (failed) {
+        throw std::runtime_error(error);
+    }
+}
+
+} // namespace text_loader
+
+// Wczytuje krawędzie "row col" (po jednej w linii) do row_idx i col_idx.
+inline void loadEdgesParallel(const std::string& filename, std::vector<int>& row_idx, std::vector<int>& col_idx) {
+    MappedFile file(filename);
+    const char* data = file.data();
+    auto bounds = text_loader::lineAlignedChunks(data, file.size(), omp_get_max_threads());
+    auto line_start = text_loader::countLines(data, bounds);
+
+    row_idx.resize(line_start.back());
+    col_idx.resize(line_start.back());
+    text_loader::parseLines(data, bounds, line_start, [&](int64_t line, const char* p, const char* end) {
+        if (!text_loader::parseNext(p, end, row_idx[line]) || !text_loader::parseNext(p, end, col_idx[line])) {
+            throw std::runtime_error("Expected two indices per line in " + filename);
+        }
+    });
+}
+
+// Wczytuje cechy wierzchołków (jeden wierzchołek na linię) do DenseMatrix.
+// Liczba kolumn to liczba wartości w pierwszej linii - każda linia musi ją mieć.
+inline DenseMatrix<double> loadFeaturesParallel(const std::string& filename) {
+    MappedFile file(filename);
+    const char* data = file.data();
+    auto bounds = text_loader::lineAlignedChunks(data, file.size(), omp_get_max_threads());
+    auto line_start = text_loader::countLines(data, bounds);
+    const int rows = static_cast<int>(line_start.back());
+
+    // liczba kolumn z pierwszej niepustej linii
+    int cols = 0;
+    for (const char* p = data; p < data + file.size() && cols == 0;) {
+        const char* end = std::find(p, data + file.size(), '\n');
+        double val;
+        for (const char* q = p; text_loader::parseNext(q, end, val);) {
+            ++cols;
+        }
+        p = end + 1;
+    }
+
+    DenseMatrix<double> features(rows, cols);
+    text_loader::parseLines(data, bounds, line_start, [&](int64_t line, const char* p, const char* end) {
+        double* row = features.row(static_cast<int>(line));
+        int count = 0;
+        double val;
+        while (text_loader::parseNext(p, end, val)) {
+            if (count == cols) {
+                throw std::runtime_error("Inconsistent number of features in " + filename);
+            }
+            row[count++] = val;
+        }
+        if (count != cols) {
+            throw std::runtime_error("Inconsistent number of features in " + filename);
+        }
+    });
+    return features;
+}
@@ -2,6 +2,51 @@ import torch
 from torch_geometric.datasets import Planetoid
 import numpy as np
 import os
+import struct
+
+# Binarny format grafu czytany przez openMP/graph_binary.h (MappedGraph):
+# nagłówek, potem indptr, indices, values (CSR) i blok cech, każda sekcja
+# wyrównana do 64 bajtów
+GRAPH_MAGIC = b'P330GRPH'
+GRAPH_VERSION = 1
+GRAPH_ALIGNMENT = 64
+GRAPH_HEADER = struct.Struct('<8sIIII7Q')
+GRAPH_DTYPES = {np.dtype(np.float32): 0, np.dtype(np.float64): 1}
+
+
+def write_graph_binary(filename, edge_index, features, num_nodes, dtype=np.float32, index_dtype=np.int32):
+    """Zapisuje graf (edge_index [2,E], features [N,F]) w formacie binarnym."""
+    dtype = np.dtype(dtype)
+    index_dtype = np.dtype(index_dtype)
+    if dtype not in GRAPH_DTYPES:
+        raise ValueError(f"Unsupported dtype {dtype} (expected float32 or float64)")
+    if index_dtype not in (np.dtype(np.int32), np.dtype(np.int64)):
+        raise ValueError(f"Unsupported index dtype {index_dtype} (expected int32 or int64)")
+
+    # COO -> CSR posortowany po (wiersz, kolumna)
+    row, col = edge_index
+    order = np.lexsort((col, row))
+    indices = col[order].astype(index_dtype)
+    indptr = np.zeros(num_nodes + 1, dtype=index_dtype)
+    np.cumsum(np.bincount(row, minlength=num_nodes), out=indptr[1:])
+    values = np.ones(len(indices), dtype=dtype)
+    features = np.ascontiguousarray(features, dtype=dtype)
+
+    sections = [indptr, indices, values, features]
+    offsets = []
+    offset = GRAPH_HEADER.size
+    for array in sections:
+        offset = (offset + GRAPH_ALIGNMENT - 1) // GRAPH_ALIGNMENT * GRAPH_ALIGNMENT
+        offsets.append(offset)
+        offset += array.nbytes
+
+    with open(filename, 'wb') as f:
+        f.write(GRAPH_HEADER.pack(GRAPH_MAGIC, GRAPH_VERSION, GRAPH_DTYPES[dtype], index_dtype.itemsize, 0,
+                                  num_nodes, len(indices), features.shape[1], *offsets))
+        for array, array_offset in zip(sections, offsets):
+            f.write(b'\0' * (array_offset - f.tell()))
+            f.write(array.tobytes())
+
 
 # Załaduj zestaw danych Planetoid
 dataset_name = 'Cora'  # Możesz wybrać 'Cora', 'Citeseer' lub 'Pubmed'
@@ -23,4 +68,7 @@ features = data.x.numpy()
 # Zapisanie cech wierzchołków do pliku
 np.savetxt("features.txt", features, fmt="%f")
 
-print("Zapisano dane: edges.txt i features.txt")
+# Ten sam graf w formacie binarnym (mapowany przez OpenMPtxtLoad graph.bin)
+write_graph_binary("graph.bin", edge_index, features, data.num_nodes)
+
+print("Zapisano dane: edges.txt, features.txt i graph.bin")
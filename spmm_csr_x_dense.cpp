@@ -1,35 +1,29 @@
 #include <iostream>
 #include <vector>
-#include <unordered_map>
-
-// Struktura CSR
-struct CSRMatrix {
-    std::vector<int> row_ptr;
-    std::vector<int> col_idx;
-    std::vector<double> values;
-    int rows;
-    int cols;
-};
+#include "csr_matrix.h"
+#include "dense_matrix.h"
 
 // Funkcja do wykonywania SpMM
-std::vector<std::vector<double>> spmm(const CSRMatrix& A, const std::vector<std::vector<double>>& B) {
+DenseMatrix<double> spmm(const CSRMatrix& A, const DenseMatrix<double>& B) {
     // Sprawdzenie wymiarów
-    if (A.cols != B.size()) {
+    if (A.cols != B.rows()) {
         throw std::invalid_argument("Dimensions of matrices are not compatible for multiplication.");
     }
 
     int rows = A.rows;
-    int cols = B[0].size();
-    std::vector<std::vector<double>> C(rows, std::vector<double>(cols, 0.0));
+    int cols = B.cols();
+    DenseMatrix<double> C(rows, cols, 0.0);
 
     // Mnożenie
     for (int i = 0; i < rows; ++i) {
+        double* c_row = C.row(i);
         for (int j = A.row_ptr[i]; j < A.row_ptr[i + 1]; ++j) {
             int a_col = A.col_idx[j];
             double a_val = A.values[j];
+            const double* b_row = B.row(a_col);
 
             for (int k = 0; k < cols; ++k) {
-                C[i][k] += a_val * B[a_col][k];
+                c_row[k] += a_val * b_row[k];
             }
         }
     }
@@ -38,7 +32,7 @@ std::vector<std::vector<double>> spmm(const CSRMatrix& A, const std::vector<std:
 }
 
 // Funkcja do wyświetlania wyniku w formacie pełnej macierzy
-void printDense(const std::vector<std::vector<double>>& C) {
+void printDense(const DenseMatrix<double>& C) {
     std::cout << "Dense matrix:" << std::endl;
     for (const auto& row : C) {
         for (double val : row) {
@@ -65,14 +59,14 @@ int main() {
     // 5 6 0
     
     // Przykładowa gęsta macierz B
-    std::vector<std::vector<double>> B = {
+    DenseMatrix<double> B = {
         {1.0, 2.0, 3.0},
         {4.0, 5.0, 6.0},
         {7.0, 8.0, 9.0}
     };
 
     // Mnożenie A * B
-    std::vector<std::vector<double>> C = spmm(A, B);
+    DenseMatrix<double> C = spmm(A, B);
     
     // Wynik powinien być taki:
 